@@ -0,0 +1,292 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Adaptive rejection sampling from a log concave density.
+
+  Gilks and Wild (1992).  The upper hull is made of the tangents to
+  h = log f at the abscissae, the squeeze of the chords between them.
+  A proposal from the hull is accepted by the squeeze when it can be,
+  and h is evaluated only when it cannot; that evaluation becomes a
+  new abscissa, up to maxpts.  The hull lives in the ARS object, so
+  later draws from the same density start from the refined hull and
+  rarely evaluate h at all.
+
+  LogDens is any functor with
+
+    double operator()(double x, double& dh) const;
+
+  returning h(x), up to a constant, and setting dh = h'(x).  It is a
+  template parameter so the calls inline.
+
+    ARS<MyDens> ars(dens, lower, upper);
+    ars.set(init, 3);           // At least two abscissae.
+    double x = ars.draw(r);
+    ars.draw(r, X, n);          // n draws on one hull.
+
+  If lower is -inf, h'(init[0]) must be positive; if upper is inf,
+  h'(init[last]) must be negative.  set returns false otherwise, or if
+  the derivatives are not decreasing, which means h is not concave.
+
+*********************************************************************/
+
+#ifndef __ARS__
+#define __ARS__
+
+#include "RNG.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+template<typename LogDens>
+class ARS {
+
+ protected:
+
+  LogDens f;
+  double  lower;
+  double  upper;
+  int     maxpts;
+
+  // Abscissae, h, and h' there.
+  std::vector<double> x;
+  std::vector<double> h;
+  std::vector<double> d;
+
+  // Piece i of the upper hull is the tangent at x[i] on [z[i-1], z[i]].
+  std::vector<double> z;
+  std::vector<double> cum;      // Cumulative mass of the pieces, to 1.
+
+  void hull();
+  void insert(double xn, double hn, double dn);
+  double squeeze(double xv) const;
+
+  static double log_area(double h0, double d0, double x0, double a, double b);
+
+ public:
+
+  ARS(const LogDens& f, double lower=-HUGE_VAL, double upper=HUGE_VAL, int maxpts=50);
+  ARS(const LogDens& f, const double* init, int n,
+      double lower=-HUGE_VAL, double upper=HUGE_VAL, int maxpts=50);
+
+  // Start over from n abscissae.
+  bool set(const double* init, int n);
+
+  template<typename Engine> double draw(RNGT<Engine>& r);
+  template<typename Engine> void   draw(RNGT<Engine>& r, double* X, int n);
+
+  int  size() const { return x.size(); }
+  bool is_set() const { return x.size() >= 2; }
+
+}; // ARS
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+template<typename LogDens>
+ARS<LogDens>::ARS(const LogDens& f_, double lower_, double upper_, int maxpts_)
+  : f(f_)
+  , lower(lower_)
+  , upper(upper_)
+  , maxpts(maxpts_)
+{
+  // Do nothing.
+}
+
+template<typename LogDens>
+ARS<LogDens>::ARS(const LogDens& f_, const double* init, int n,
+		  double lower_, double upper_, int maxpts_)
+  : f(f_)
+  , lower(lower_)
+  , upper(upper_)
+  , maxpts(maxpts_)
+{
+  set(init, n);
+}
+
+//////////////////////////////////////////////////////////////////////
+			       // Hull //
+//////////////////////////////////////////////////////////////////////
+
+template<typename LogDens>
+bool ARS<LogDens>::set(const double* init, int n)
+{
+  x.assign(init, init + n);
+  std::sort(x.begin(), x.end());
+  x.erase(std::unique(x.begin(), x.end()), x.end());
+
+  int k = x.size();
+  if (k < 2 || x[0] <= lower || x[k-1] >= upper) {
+    fprintf(stderr, "ARS::set: need two distinct abscissae inside (%g, %g).\n", lower, upper);
+    x.clear();
+    return false;
+  }
+
+  h.resize(k);
+  d.resize(k);
+  for (int i = 0; i < k; i++)
+    h[i] = f(x[i], d[i]);
+
+  bool ok = true;
+  if (lower == -HUGE_VAL && !(d[0] > 0)) {
+    fprintf(stderr, "ARS::set: h'(%g) = %g must be > 0 when lower is -inf.\n", x[0], d[0]);
+    ok = false;
+  }
+  if (upper == HUGE_VAL && !(d[k-1] < 0)) {
+    fprintf(stderr, "ARS::set: h'(%g) = %g must be < 0 when upper is inf.\n", x[k-1], d[k-1]);
+    ok = false;
+  }
+  for (int i = 1; i < k; i++)
+    if (d[i] > d[i-1]) {
+      fprintf(stderr, "ARS::set: h' increases at %g; the density is not log concave.\n", x[i]);
+      ok = false;
+      break;
+    }
+
+  if (!ok) {
+    x.clear();
+    return false;
+  }
+
+  hull();
+  return true;
+}
+
+// log of the integral of exp(h0 + d0 (t - x0)) over [a, b], written so
+// that an infinite end is fine when the tangent decays toward it.
+
+template<typename LogDens>
+double ARS<LogDens>::log_area(double h0, double d0, double x0, double a, double b)
+{
+  if (d0 > 0)
+    return h0 + d0 * (b - x0) + log1p(-exp(-d0 * (b - a))) - log(d0);
+  if (d0 < 0)
+    return h0 + d0 * (a - x0) + log1p(-exp(d0 * (b - a))) - log(-d0);
+  return h0 + log(b - a);
+}
+
+template<typename LogDens>
+void ARS<LogDens>::hull()
+{
+  int k = x.size();
+  z.resize(k);
+  cum.resize(k);
+
+  // Where tangents i and i+1 cross.  Nearly parallel tangents cross
+  // far away or nowhere; use the midpoint.
+  for (int i = 0; i < k-1; i++) {
+    double dd = d[i] - d[i+1];
+    double zi = 0.5 * (x[i] + x[i+1]);
+    if (dd > 1e-10 * (fabs(d[i]) + fabs(d[i+1])))
+      zi = (h[i+1] - h[i] - x[i+1] * d[i+1] + x[i] * d[i]) / dd;
+    z[i] = std::min(std::max(zi, x[i]), x[i+1]);
+  }
+  z[k-1] = upper;
+
+  double hmax = -HUGE_VAL;
+  for (int i = 0; i < k; i++) {
+    cum[i] = log_area(h[i], d[i], x[i], i ? z[i-1] : lower, z[i]);
+    hmax   = std::max(hmax, cum[i]);
+  }
+  double total = 0.0;
+  for (int i = 0; i < k; i++) {
+    total += exp(cum[i] - hmax);
+    cum[i] = total;
+  }
+  for (int i = 0; i < k; i++)
+    cum[i] /= total;
+}
+
+template<typename LogDens>
+void ARS<LogDens>::insert(double xn, double hn, double dn)
+{
+  int i = std::lower_bound(x.begin(), x.end(), xn) - x.begin();
+  if (i < (int)x.size() && x[i] == xn) return;
+  x.insert(x.begin() + i, xn);
+  h.insert(h.begin() + i, hn);
+  d.insert(d.begin() + i, dn);
+  hull();
+}
+
+// The chord through the neighboring abscissae, -inf outside them.
+
+template<typename LogDens>
+double ARS<LogDens>::squeeze(double xv) const
+{
+  int k = x.size();
+  if (xv < x[0] || xv > x[k-1]) return -HUGE_VAL;
+  int i = std::upper_bound(x.begin(), x.end(), xv) - x.begin() - 1;
+  if (i > k-2) i = k-2;
+  return ((x[i+1] - xv) * h[i] + (xv - x[i]) * h[i+1]) / (x[i+1] - x[i]);
+}
+
+//////////////////////////////////////////////////////////////////////
+			       // Draw //
+//////////////////////////////////////////////////////////////////////
+
+template<typename LogDens> template<typename Engine>
+double ARS<LogDens>::draw(RNGT<Engine>& r)
+{
+  if (!is_set()) {
+    fprintf(stderr, "ARS::draw: no hull; call set.\n");
+    return 0.0;
+  }
+
+  while (true) {
+    // Piece j of the hull, then a truncated exponential on it.
+    int k = x.size();
+    int j = std::lower_bound(cum.begin(), cum.end(), r.unif()) - cum.begin();
+    if (j > k-1) j = k-1;
+
+    double a  = j ? z[j-1] : lower;
+    double b  = z[j];
+    double u  = r.unif();
+    double dj = d[j];
+    double xs;
+    if (dj * (b - a) > 1e-12)
+      xs = b + log1p(-u * -expm1(-dj * (b - a))) / dj;
+    else if (dj * (b - a) < -1e-12)
+      xs = a + log1p(-u * -expm1(dj * (b - a))) / dj;
+    else
+      xs = a + u * (b - a);
+
+    // Accept when log U + hull(xs) < h(xs), by the squeeze if possible.
+    double t = h[j] + dj * (xs - x[j]) - r.expon_rate(1.0);
+    if (t <= squeeze(xs)) return xs;
+
+    double dn;
+    double hn = f(xs, dn);
+    if ((int)x.size() < maxpts) insert(xs, hn, dn);
+    if (t <= hn) return xs;
+  }
+}
+
+template<typename LogDens> template<typename Engine>
+void ARS<LogDens>::draw(RNGT<Engine>& r, double* X, int n)
+{
+  if (!is_set()) {
+    fprintf(stderr, "ARS::draw: no hull; call set.\n");
+    return;
+  }
+  for (int i = 0; i < n; i++)
+    X[i] = draw(r);
+}
+
+#endif
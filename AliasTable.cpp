@@ -0,0 +1,115 @@
+// -*- c-basic-offset: 4; -*-
+#include "AliasTable.hpp"
+#include <stdio.h>
+#include <cmath>
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+AliasTable::AliasTable()
+    : K(0)
+{
+    // Do nothing.
+}
+
+AliasTable::AliasTable(const double* w, int K_, bool use_log)
+    : K(0)
+{
+    if (use_log) set_log(w, K_);
+    else set(w, K_);
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Set //
+//////////////////////////////////////////////////////////////////////
+
+bool AliasTable::set(const double* w, int K_)
+{
+    K = K_;
+    prob.resize(K);
+    alias.resize(K);
+
+    double total = 0.0;
+    for (int i = 0; i < K; i++) {
+	if (!(w[i] >= 0)) {
+	    fprintf(stderr, "AliasTable::set: weight %i is %g.\n", i, w[i]);
+	    K = 0;
+	    return false;
+	}
+	prob[i] = w[i];
+	total  += w[i];
+    }
+
+    return build(total);
+}
+
+bool AliasTable::set_log(const double* lw, int K_)
+{
+    K = K_;
+    prob.resize(K);
+    alias.resize(K);
+
+    double mx = -HUGE_VAL;
+    for (int i = 0; i < K; i++)
+	mx = lw[i] > mx ? lw[i] : mx;
+
+    if (!(mx > -HUGE_VAL) || mx == HUGE_VAL) {
+	fprintf(stderr, "AliasTable::set_log: max log weight is %g.\n", mx);
+	K = 0;
+	return false;
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < K; i++) {
+	prob[i] = exp(lw[i] - mx);
+	total  += prob[i];
+    }
+
+    return build(total);
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Vose //
+//////////////////////////////////////////////////////////////////////
+
+// prob holds unnormalized weights on entry.  Scale them to have mean 1,
+// then repeatedly pair a category below 1 with one above 1.
+
+bool AliasTable::build(double total)
+{
+    if (!(total > 0) || total == HUGE_VAL) {
+	fprintf(stderr, "AliasTable: sum of weights is %g.\n", total);
+	K = 0;
+	return false;
+    }
+
+    std::vector<int> small, large;
+    small.reserve(K);
+    large.reserve(K);
+
+    double scale = K / total;
+    for (int i = 0; i < K; i++) {
+	prob[i] *= scale;
+	alias[i] = i;
+	if (prob[i] < 1.0) small.push_back(i);
+	else large.push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+	int s = small.back(); small.pop_back();
+	int l = large.back();
+	alias[s]  = l;
+	prob[l]  -= 1.0 - prob[s];
+	if (prob[l] < 1.0) {
+	    large.pop_back();
+	    small.push_back(l);
+	}
+    }
+
+    // Whatever is left is 1 up to rounding.
+    for (unsigned int i = 0; i < large.size(); i++) prob[large[i]] = 1.0;
+    for (unsigned int i = 0; i < small.size(); i++) prob[small[i]] = 1.0;
+
+    return true;
+}
@@ -0,0 +1,75 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Walker's alias method, built with Vose's algorithm.
+
+  Setting up a table for K categories is O(K).  After that a draw costs
+  one uniform, one multiplication, and one comparison, whatever K is.
+  Build the table once and reuse it for every draw with the same
+  weights.
+
+  The weights need not be normalized.  set_log takes log weights: one
+  pass finds their maximum, a second exponentiates them less the
+  maximum and sums the results, and the build scales them to mean 1
+  in a third.  That way huge or tiny log likelihoods do not overflow
+  or underflow to an all zero table.
+
+  The table does not hold an RNG.  Pass it a uniform on [0,1), or use
+  RNG::categorical.
+
+*********************************************************************/
+
+#ifndef __ALIASTABLE__
+#define __ALIASTABLE__
+
+#include <vector>
+
+class AliasTable {
+
+ protected:
+
+  int K;
+  std::vector<double> prob;
+  std::vector<int>    alias;
+
+  bool build(double total);
+
+ public:
+
+  AliasTable();
+  AliasTable(const double* w, int K_, bool use_log=false);
+
+  // Return false if the weights are negative, NaN, or all zero.
+  bool set    (const double* w , int K_);
+  bool set_log(const double* lw, int K_);
+
+  int size() const { return K; }
+
+  // Category in 0, ..., K-1.
+  int draw(double u) const
+  {
+    double x = u * K;
+    int    i = (int)x;
+    if (i >= K) i = K - 1;
+    return (x - i) < prob[i] ? i : alias[i];
+  }
+
+}; // AliasTable
+
+#endif
@@ -0,0 +1,148 @@
+// -*- c-basic-offset: 4; -*-
+#ifndef USE_R
+#include "BufferedRNG.hpp"
+#include "RNGImpl.hpp"
+#include <sched.h>
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+BufferedEngine::BufferedEngine(unsigned long seed, unsigned int capacity_, bool background_)
+    : GRNG(seed)
+    , capacity(1)
+    , background(background_)
+    , stop(0)
+    , sleeping(0)
+{
+    while (capacity < capacity_) capacity <<= 1;
+    low = capacity / 2;
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&wake, NULL);
+
+    // Seed the rings from their own generator so that they do not
+    // overlap with each other or with the base stream.
+    gsl_rng* seeder = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(seeder, seed);
+
+    for (int k = 0; k < BUF_NKIND; k++) {
+	Ring& R = ring[k];
+	R.buf   = new double[capacity];
+	R.gen   = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(R.gen, gsl_rng_get(seeder));
+	R.idx.head = 0;
+	R.idx.tail = 0;
+	R.reader.attach(&R.idx, R.buf, capacity);
+    }
+
+    gsl_rng_free(seeder);
+
+    if (background && pthread_create(&thread, NULL, &BufferedEngine::produce, this) != 0) {
+	fprintf(stderr, "BufferedEngine: could not start producer; drawing on demand.\n");
+	background = false;
+    }
+}
+
+BufferedEngine::~BufferedEngine()
+{
+    if (background) {
+	stop = 1;
+	__sync_synchronize();
+	rouse();
+	pthread_join(thread, NULL);
+    }
+    pthread_cond_destroy(&wake);
+    pthread_mutex_destroy(&lock);
+    for (int k = 0; k < BUF_NKIND; k++) {
+	delete[] ring[k].buf;
+	gsl_rng_free(ring[k].gen);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Producer //
+//////////////////////////////////////////////////////////////////////
+
+// Fill one chunk of empty places and publish it.  Return whether there
+// was any room.
+
+bool BufferedEngine::fill(Ring& R)
+{
+    uint32_t at;
+    uint32_t room = ring_room(R.idx, capacity, at);
+    if (room == 0) return false;
+
+    generate(R.gen, &R - ring, R.buf + at, room);
+    ring_push(R.idx, room);
+    return true;
+}
+
+// Whether any ring holds no more than low.
+
+bool BufferedEngine::drained() const
+{
+    for (int k = 0; k < BUF_NKIND; k++)
+	if (ring_level(ring[k].idx) <= low) return true;
+    return false;
+}
+
+// Every ring is full.  Sleep until the consumer drains one to low, or
+// the engine is destroyed.
+
+void BufferedEngine::sleep()
+{
+    pthread_mutex_lock(&lock);
+    sleeping = 1;
+    __sync_synchronize();
+    while (sleeping && !stop && !drained())
+	pthread_cond_wait(&wake, &lock);
+    sleeping = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+void BufferedEngine::rouse()
+{
+    pthread_mutex_lock(&lock);
+    if (sleeping || stop) {
+	sleeping = 0;
+	pthread_cond_signal(&wake);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void* BufferedEngine::produce(void* self)
+{
+    BufferedEngine* b = (BufferedEngine*)self;
+
+    while (!b->stop) {
+	bool busy = false;
+	for (int k = 0; k < BUF_NKIND; k++)
+	    busy = b->fill(b->ring[k]) || busy;
+	if (!busy) b->sleep();
+	__sync_synchronize();
+    }
+
+    return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Consumer //
+//////////////////////////////////////////////////////////////////////
+
+// Give back everything read so far and wait for more.
+
+void BufferedEngine::wait(Ring& R)
+{
+    publish(R);
+    while (!R.reader.refresh())
+	sched_yield();
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Instantiate //
+//////////////////////////////////////////////////////////////////////
+
+template class RNGT<BufferedEngine>;
+
+#endif
@@ -0,0 +1,161 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  An RNG whose uniforms, standard normals, and standard exponentials
+  are made ahead of time by a background thread.
+
+  BufferedEngine is a GRNG whose unif, norm, and expon_rate pop from
+  one single producer / single consumer ring per kind of variate.  The
+  producer thread fills whichever rings have room, so these, and every
+  sampler of BufferedRNG = RNGT<BufferedEngine> built on them, never
+  wait on the generator unless a ring runs dry.  The rings are lock
+  free; see SPSCRing.hpp.
+
+  Each ring has its own Mersenne Twister, seeded from the seed passed
+  to the constructor.  The k-th uniform is therefore the same however
+  the threads are scheduled, and a BufferedRNG constructed with
+  background=false, which fills nothing ahead and draws on demand,
+  gives exactly the same variates.  Other variates, e.g. gamma_rate,
+  come from the underlying GRNG as usual.
+
+  The producer runs as long as the object lives.  When every ring is
+  full it sleeps on a condition variable, and the consumer wakes it
+  once a ring has drained to half its capacity, so an idle BufferedRNG
+  costs no CPU.  Use one BufferedRNG per consuming thread.  It needs
+  GSL and pthreads; R's generator may not be called from another
+  thread.
+
+*********************************************************************/
+
+#ifndef USE_R
+#ifndef __BUFFEREDRNG__
+#define __BUFFEREDRNG__
+
+#include "RNG.hpp"
+#include "SPSCRing.hpp"
+#include <pthread.h>
+
+class BufferedEngine : public GRNG {
+
+ public:
+
+  enum Kind {BUF_UNIF=0, BUF_NORM=1, BUF_EXPON=2, BUF_NKIND=3};
+
+ protected:
+
+  struct Ring {
+    double*    buf;
+    gsl_rng*   gen;
+    RingIndex  idx;
+    RingReader reader;
+  };
+
+  Ring     ring[BUF_NKIND];
+  uint32_t capacity;
+
+  bool      background;
+  pthread_t thread;
+  volatile int stop;
+
+  // The producer sleeps on wake while every ring holds more than low.
+  pthread_mutex_t lock;
+  pthread_cond_t  wake;
+  volatile int    sleeping;
+  uint32_t        low;
+
+  static void* produce(void* self);
+  bool fill(Ring& R);
+  bool drained() const;
+  void sleep();
+  void rouse();
+  void publish(Ring& R);
+  void wait(Ring& R);
+
+  static double generate(gsl_rng* gen, int kind)
+  {
+    switch (kind) {
+    case BUF_NORM:
+      return gsl_ran_gaussian_ziggurat(gen, 1.0);
+    case BUF_EXPON:
+      return -log(gsl_rng_uniform_pos(gen));
+    default:
+      return gsl_rng_uniform(gen);
+    }
+  }
+
+  static void generate(gsl_rng* gen, int kind, double* x, uint32_t n)
+  {
+    for (uint32_t i = 0; i < n; i++) x[i] = generate(gen, kind);
+  }
+
+  double pop(int kind);
+
+  // Not copyable: the producer thread holds a pointer to this.
+  BufferedEngine(const BufferedEngine&);
+  BufferedEngine& operator=(const BufferedEngine&);
+
+ public:
+
+  // capacity is rounded up to a power of two.  The seed defaults to the
+  // time, as GRNG's does.
+  BufferedEngine(unsigned long seed=time(NULL), unsigned int capacity=4096, bool background=true);
+  virtual ~BufferedEngine();
+
+  double unif() { return pop(BUF_UNIF); }
+  double norm(double sd) { return sd * pop(BUF_NORM); }
+  double norm(double mean, double sd) { return mean + sd * pop(BUF_NORM); }
+  double expon_rate(double rate) { return pop(BUF_EXPON) / rate; }
+  double expon_mean(double mean) { return mean * pop(BUF_EXPON); }
+
+}; // BufferedEngine
+
+typedef RNGT<BufferedEngine> BufferedRNG;
+
+//////////////////////////////////////////////////////////////////////
+			    // Consumer //
+//////////////////////////////////////////////////////////////////////
+
+inline double BufferedEngine::pop(int kind)
+{
+    Ring& R = ring[kind];
+
+    if (!background)
+	return generate(R.gen, kind);
+
+    if (R.reader.empty()) wait(R);
+
+    double x = R.reader.next();
+    if (R.reader.due()) publish(R);
+    return x;
+}
+
+// Give the producer the head, and wake it if it sleeps on a ring that
+// has drained.  The head must be visible before sleeping is read, as
+// sleeping is before the heads are in sleep, so that one side sees the
+// other.
+
+inline void BufferedEngine::publish(Ring& R)
+{
+    R.reader.publish();
+    __sync_synchronize();
+    if (sleeping && R.reader.level() <= low) rouse();
+}
+
+#endif // __BUFFEREDRNG__
+#endif // check USE_R
@@ -15,6 +15,7 @@ class RNGPar {
 protected:
 
   int nrng;
+  unsigned long seed;           // Stream i is seeded with seed + i.
   vector<RNG> r;
 
 public:
@@ -26,16 +27,31 @@ public:
 
   ExponMean<RealType> expon_mean_sampler;
 
+  int           size()     const { return nrng; }
+  unsigned long get_seed() const { return seed; }
+  const char*   engine()   const { return gsl_rng_name(r[0].getrng()); }
+
   void expon_mean (RealType* samp, int nsamp, RealType* mean, int npar);
   void expon_rate (RealType* samp, int nsamp, RealType* rate, int npar);
   void chisq      (RealType* samp, int nsamp, RealType*   df, int npar);
   void norm       (RealType* samp, int nsamp, RealType*   sd, int npar);
+  void poisson    (RealType* samp, int nsamp, RealType*   mu, int npar);
 
   void norm        (RealType* samp, int nsamp, RealType*  mean, RealType*    sd, int npar);
   void gamma_scale (RealType* samp, int nsamp, RealType* shape, RealType* scale, int npar);
   void gamma_rate  (RealType* samp, int nsamp, RealType* shape, RealType*  rate, int npar);
   void igamma      (RealType* samp, int nsamp, RealType* shape, RealType* scale, int npar);
   void flat        (RealType* samp, int nsamp, RealType* lower, RealType* upper, int npar);
+  void polyagamma  (RealType* samp, int nsamp, RealType*     b, RealType*     z, int npar);
+  void binom       (RealType* samp, int nsamp, RealType*     n, RealType*     p, int npar);
+  void negbin      (RealType* samp, int nsamp, RealType*  size, RealType*     p, int npar);
+
+  // K categories or components.  dirichlet and multinomial write ndraw
+  // draws of length K one after another.
+  void categorical    (RealType* samp, int nsamp, RealType*  p, int K);
+  void categorical_log(RealType* samp, int nsamp, RealType* lw, int K);
+  void dirichlet      (RealType* samp, int ndraw, RealType* alpha, int K);
+  void multinomial    (RealType* samp, int ndraw, int N, RealType* p, int K);
 
   void test        (RealType* samp, int nsamp, RealType* p1, int npar);
 
@@ -44,24 +60,26 @@ public:
 template<typename RealType>
 RNGPar<RealType>::RNGPar() 
   : nrng(1)
+  , seed(time(NULL))
   , r(1)
 {
-  // Do nothing.
+  r[0].set(seed);
 }
 
 template<typename RealType>
 RNGPar<RealType>::RNGPar(int nrng_)
   : nrng(nrng_)
+  , seed(time(NULL))
   , r(nrng_)
 {
-  unsigned long seed = time(NULL);
   for (int i = 0; i < nrng; i++)
     r[i].set(seed+i);
 }
 
 template<typename RealType>
-RNGPar<RealType>::RNGPar(int nrng_, unsigned long seed)
+RNGPar<RealType>::RNGPar(int nrng_, unsigned long seed_)
   : nrng(nrng_)
+  , seed(seed_)
   , r(nrng_)
 {
   for (int i = 0; i < nrng; i++)
@@ -94,18 +112,103 @@ void RNGPar<RealType>::test(RealType* samp, int nsamp, RealType* p1, int npar)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Categorical, Dirichlet, multinomial.  The alias table is built once and
+// shared by the threads, which only read it.
+
+template<typename RealType>
+void RNGPar<RealType>::categorical(RealType* samp, int nsamp, RealType* p, int K)
+{
+  vector<double> w(p, p + K);
+  AliasTable tab(&w[0], K);
+  if (tab.size() == 0) return;
+
+  vector<RNG>* rp = &r;
+  int i;
+
+  #pragma omp parallel shared(samp, tab, rp) private(i) num_threads(nrng)
+  {
+    RNG* rngp = &(rp->operator[](omp_get_thread_num()));
+
+    #pragma omp for schedule(static) nowait
+    for (i = 0; i < nsamp; i++)
+      samp[i] = tab.draw(rngp->unif());
+  }
+}
+
+template<typename RealType>
+void RNGPar<RealType>::categorical_log(RealType* samp, int nsamp, RealType* lw, int K)
+{
+  vector<double> w(lw, lw + K);
+  AliasTable tab(&w[0], K, true);
+  if (tab.size() == 0) return;
+
+  vector<RNG>* rp = &r;
+  int i;
+
+  #pragma omp parallel shared(samp, tab, rp) private(i) num_threads(nrng)
+  {
+    RNG* rngp = &(rp->operator[](omp_get_thread_num()));
+
+    #pragma omp for schedule(static) nowait
+    for (i = 0; i < nsamp; i++)
+      samp[i] = tab.draw(rngp->unif());
+  }
+}
+
+template<typename RealType>
+void RNGPar<RealType>::dirichlet(RealType* samp, int ndraw, RealType* alpha, int K)
+{
+  vector<double> a(alpha, alpha + K);
+  vector<RNG>* rp = &r;
+  int i;
+
+  #pragma omp parallel shared(samp, a, rp) private(i) num_threads(nrng)
+  {
+    RNG* rngp = &(rp->operator[](omp_get_thread_num()));
+    vector<double> x(K);
+
+    #pragma omp for schedule(static) nowait
+    for (i = 0; i < ndraw; i++) {
+      rngp->dirichlet(&x[0], &a[0], K);
+      for (int k = 0; k < K; k++) samp[i*K+k] = x[k];
+    }
+  }
+}
+
+template<typename RealType>
+void RNGPar<RealType>::multinomial(RealType* samp, int ndraw, int N, RealType* p, int K)
+{
+  vector<double> w(p, p + K);
+  vector<RNG>* rp = &r;
+  int i;
+
+  #pragma omp parallel shared(samp, w, rp) private(i) num_threads(nrng)
+  {
+    RNG* rngp = &(rp->operator[](omp_get_thread_num()));
+    vector<int> c(K);
+
+    #pragma omp for schedule(static) nowait
+    for (i = 0; i < ndraw; i++) {
+      rngp->multinomial(&c[0], N, &w[0], K);
+      for (int k = 0; k < K; k++) samp[i*K+k] = c[k];
+    }
+  }
+}
+
 #define ONEP(FNAME, CNAME)						\
   template <typename RealType>						\
   void RNGPar<RealType>:: FNAME (RealType* samp, int nsamp, RealType* p1, int npar) \
   {									\
     CNAME <RealType> sampler;						\
-    draw_parallel<RealType>(samp, nsamp, p1, npar, expon_mean_sampler, &r);	\
+    draw_parallel<RealType>(samp, nsamp, p1, npar, sampler, &r);	\
   }									\
 
 ONEP(expon_mean, ExponMean)
 ONEP(expon_rate, ExponRate)
 ONEP(chisq     ,     ChiSq)
 ONEP(norm      ,     Norm1)
+ONEP(poisson   ,   Poisson)
 
 #undef ONEP
 
@@ -122,6 +225,9 @@ TWOP(gamma_scale, GammaScale)
 TWOP(gamma_rate , GammaRate)
 TWOP(igamma     , IGamma)
 TWOP(flat       , Flat)
+TWOP(polyagamma , PolyaGamma)
+TWOP(binom      , Binom)
+TWOP(negbin     , NegBin)
 
 #undef TWOP
 
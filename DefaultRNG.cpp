@@ -0,0 +1,98 @@
+// -*- c-basic-offset: 4; -*-
+#ifndef USE_R
+#include "DefaultRNG.hpp"
+#include <pthread.h>
+
+namespace {
+
+    struct Local {
+	RNG          r;
+	unsigned int stream;
+	int          epoch;
+    };
+
+    pthread_key_t  key;
+    pthread_once_t once = PTHREAD_ONCE_INIT;
+
+    // Written by rng::seed only; seed before epoch.
+    volatile unsigned long base  = 0;
+    volatile int           epoch = 0;
+    volatile unsigned int  next  = 0;
+
+    void destroy(void* p) { delete static_cast<Local*>(p); }
+
+    void make_key()
+    {
+	pthread_key_create(&key, destroy);
+	if (epoch == 0) {
+	    base = time(NULL);
+	    __sync_synchronize();
+	    epoch = 1;
+	}
+    }
+
+    void reseed(Local* L, int e)
+    {
+	__sync_synchronize();
+	L->r.set(base + L->stream);
+	L->epoch = e;
+    }
+
+    Local* get()
+    {
+	pthread_once(&once, make_key);
+	Local* L = static_cast<Local*>(pthread_getspecific(key));
+	if (!L) {
+	    L = new Local;
+	    L->stream = __sync_fetch_and_add(&next, 1);
+	    reseed(L, epoch);
+	    pthread_setspecific(key, L);
+	}
+	return L;
+    }
+
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Access //
+//////////////////////////////////////////////////////////////////////
+
+RNG& rng::local()
+{
+    Local* L = get();
+    int    e = epoch;
+    if (L->epoch != e) reseed(L, e);
+    return L->r;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Seeds //
+//////////////////////////////////////////////////////////////////////
+
+void rng::seed(unsigned long s)
+{
+    pthread_once(&once, make_key);
+    base = s;
+    __sync_synchronize();
+    __sync_fetch_and_add(&epoch, 1);
+}
+
+unsigned long rng::get_seed()
+{
+    pthread_once(&once, make_key);
+    return base;
+}
+
+void rng::set_stream(unsigned int k)
+{
+    Local* L = get();
+    L->stream = k;
+    reseed(L, epoch);
+}
+
+unsigned int rng::stream()
+{
+    return get()->stream;
+}
+
+#endif
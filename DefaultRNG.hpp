@@ -0,0 +1,84 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  A default RNG for each thread, for code that has no RNG& to hand.
+
+    rng::norm(1.0);                  // This thread's stream.
+    rng::local().polyagamma(1, z);   // Anything else RNG samples.
+
+  Each thread gets its own RNG the first time it draws, so there is
+  nothing to lock and nothing to construct per call.  It is destroyed
+  when the thread exits.  Stream k is seeded with seed + k, as stream k
+  of RNGPar is, and threads take the streams 0, 1, 2, ... in the order
+  in which they first draw.  Pin a thread to a stream with
+  rng::set_stream, e.g. to omp_get_thread_num(), when that order is not
+  fixed from run to run.
+
+  rng::seed reseeds every stream.  It bumps an epoch that each thread
+  checks before it draws, so streams are reseeded lazily, with no
+  locks.  Call it between parallel regions, not while other threads
+  are drawing.  Until it is called the seed is the time, as for RNG.
+
+  Needs GSL and pthreads; R's generator is not per thread.
+
+*********************************************************************/
+
+#ifndef USE_R
+#ifndef __DEFAULTRNG__
+#define __DEFAULTRNG__
+
+#include "RNG.hpp"
+
+namespace rng {
+
+  // This thread's RNG.
+  RNG& local();
+
+  // Reseed every stream with seed + stream.
+  void seed(unsigned long s);
+  unsigned long get_seed();
+
+  // Reseed this thread's RNG as stream k.
+  void set_stream(unsigned int k);
+  unsigned int stream();
+
+  inline double unif() { return local().unif(); }
+  inline double flat(double a=0, double b=1) { return local().flat(a, b); }
+  inline double norm(double sd) { return local().norm(sd); }
+  inline double norm(double mean, double sd) { return local().norm(mean, sd); }
+  inline double expon_rate(double rate) { return local().expon_rate(rate); }
+  inline double expon_mean(double mean) { return local().expon_mean(mean); }
+  inline double gamma_rate (double shape, double rate ) { return local().gamma_rate(shape, rate); }
+  inline double gamma_scale(double shape, double scale) { return local().gamma_scale(shape, scale); }
+  inline double igamma(double shape, double scale) { return local().igamma(shape, scale); }
+  inline double chisq (double df) { return local().chisq(df); }
+  inline double beta  (double a, double b) { return local().beta(a, b); }
+  inline int    bern  (double p) { return local().bern(p); }
+  inline double tnorm (double left) { return local().tnorm(left); }
+  inline double tnorm (double left, double right) { return local().tnorm(left, right); }
+  inline double tnorm (double left, double right, double mu, double sd) { return local().tnorm(left, right, mu, sd); }
+  inline double igauss(double mu, double lambda) { return local().igauss(mu, lambda); }
+  inline double polyagamma(double b, double z) { return local().polyagamma(b, z); }
+  inline int    poisson(double mu) { return local().poisson(mu); }
+  inline int    binom  (int n, double p) { return local().binom(n, p); }
+
+} // rng
+
+#endif // __DEFAULTRNG__
+#endif // check USE_R
@@ -0,0 +1,144 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  The rest of an engine, given its uniforms.
+
+  An engine for RNGT must supply unif, norm, gamma_scale, and so on;
+  see GRNG.hpp.  GRNG and RRNG get them from GSL or R.  An engine that
+  only has a source of uniforms derives from EngineBase<Engine> and
+  defines
+
+    double unif();   // In (0, 1).
+
+  and EngineBase fills in the rest, calling Engine::unif through the
+  curiously recurring template.  Wherever it can, EngineBase inverts
+  the CDF, one uniform per draw:
+
+    expon  : -log(1 - U)
+    norm   : RNGMath::q_norm(U)
+    flat   : a + (b - a) U
+    bern   : U < p
+
+  The gamma needs a rejection sampler (Marsaglia and Tsang, 2000) and
+  chisq, igamma, and beta are built on it.  The CDFs and the gamma
+  function come from RNGMath.
+
+  An engine may hide any of these with a better version of its own.
+
+*********************************************************************/
+
+#ifndef __ENGINEBASE__
+#define __ENGINEBASE__
+
+#include <stdint.h>
+#include <cmath>
+#include "RNGMath.hpp"
+
+template<typename Engine>
+class EngineBase {
+
+ protected:
+
+  Engine& engine() { return *static_cast<Engine*>(this); }
+
+ public:
+
+  // Random variates.
+  uint32_t bits32()
+    { return (uint32_t)(engine().unif() * 4294967296.0); }
+
+  double expon_mean(double mean) { return -mean * log1p(-engine().unif()); }
+  double expon_rate(double rate) { return engine().expon_mean(1.0 / rate); }
+
+  double norm(double sd) { return sd * RNGMath::q_norm(engine().unif()); }
+  double norm(double mean, double sd) { return mean + engine().norm(sd); }
+
+  double flat(double a=0, double b=1) { return a + (b - a) * engine().unif(); }
+
+  double gamma_scale(double shape, double scale);
+  double gamma_rate (double shape, double rate) { return engine().gamma_scale(shape, 1.0 / rate); }
+  double igamma(double shape, double scale) { return 1.0 / engine().gamma_scale(shape, 1.0 / scale); }
+  double chisq (double df) { return engine().gamma_scale(0.5 * df, 2.0); }
+
+  double beta(double a=1.0, double b=1.0)
+  {
+    double x = engine().gamma_scale(a, 1.0);
+    double y = engine().gamma_scale(b, 1.0);
+    return x / (x + y);
+  }
+
+  int bern(double p) { return engine().unif() < p; }
+
+  // CDF
+  static double p_norm(double x, int use_log=0)
+  {
+    return use_log ? RNGMath::log_p_norm(x) : RNGMath::p_norm(x);
+  }
+
+  static double p_gamma_rate(double x, double shape, double rate, int use_log=0)
+  {
+    double y = RNGMath::p_gamma(rate * x, shape, RNGMath::lgamma(shape));
+    return use_log ? log(y) : y;
+  }
+
+  // Density
+  static double d_beta(double x, double a, double b)
+  {
+    double lB = RNGMath::lgamma(a) + RNGMath::lgamma(b) - RNGMath::lgamma(a+b);
+    return exp((a-1) * log(x) + (b-1) * log1p(-x) - lB);
+  }
+
+  // Utility
+  static double Gamma(double x, int use_log=0)
+  {
+    double y = RNGMath::lgamma(x);
+    return use_log ? y : exp(y);
+  }
+
+}; // EngineBase
+
+// Marsaglia and Tsang, A simple method for generating gamma variables
+// (2000).  For shape < 1 use Ga(shape) = Ga(shape + 1) U^{1/shape}.
+
+template<typename Engine>
+double EngineBase<Engine>::gamma_scale(double shape, double scale)
+{
+    if (shape < 1.0) {
+	double u = engine().unif();
+	return gamma_scale(shape + 1.0, scale) * pow(u, 1.0 / shape);
+    }
+
+    double d = shape - 1.0 / 3.0;
+    double c = 1.0 / sqrt(9.0 * d);
+
+    while (true) {
+	double x, v;
+	do {
+	    x = engine().norm(1.0);
+	    v = 1.0 + c * x;
+	} while (v <= 0);
+
+	v = v * v * v;
+	double u = engine().unif();
+	if (u < 1.0 - 0.0331 * x * x * x * x) return scale * d * v;
+	if (log(u) < 0.5 * x * x + d * (1.0 - v + log(v))) return scale * d * v;
+    }
+}
+
+#endif
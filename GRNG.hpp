@@ -21,14 +21,18 @@
   for random number generation since it has a large period, which is
   what we want for MCMC simulation.
 
+  GRNG is an engine for RNGT.  Everything is inline so that the
+  uniforms and normals can be inlined into RNGT's samplers.
+
   When compiling include -lgsl -lcblas -llapack .
 
 *********************************************************************/
 
-#ifndef __BASICRNG__
-#define __BASICRNG__
+#ifndef __GRNG__
+#define __GRNG__
 
 #include <stdio.h>
+#include <stdint.h>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_cdf.h>
@@ -48,7 +52,7 @@ using std::ifstream;
 			      // RNG //
 //////////////////////////////////////////////////////////////////////
 
-class BasicRNG {
+class GRNG {
 
  protected:
 
@@ -57,15 +61,15 @@ class BasicRNG {
  public:
 
   // Constructors and destructors.
-  BasicRNG();
-  BasicRNG(unsigned long seed);
-  BasicRNG(const BasicRNG& rng);
+  GRNG();
+  GRNG(unsigned long seed);
+  GRNG(const GRNG& rng);
 
-  virtual ~BasicRNG()
+  virtual ~GRNG()
     { gsl_rng_free (r); }
 
   // Assignment=
-  BasicRNG& operator=(const BasicRNG& rng);
+  GRNG& operator=(const GRNG& rng);
 
   // Read / Write / Set
   bool read (const string& filename);
@@ -73,12 +77,13 @@ class BasicRNG {
   void set(unsigned long seed);
 
   // Get rng -- be careful.  Needed for other random variates.
-  gsl_rng* getrng() { return r; }
+  gsl_rng* getrng() const { return r; }
 
   // Random variates.
   double unif  ();                             // Uniform
-  double expon_mean(double mean);     // Exponential
-  double expon_rate(double rate);                  // Exponential
+  uint32_t bits32();                           // 32 random bits
+  double expon_mean(double mean);              // Exponential
+  double expon_rate(double rate);              // Exponential
   double chisq (double df);                    // Chisq
   double norm  (double sd);                    // Normal
   double norm  (double mean , double sd);      // Normal
@@ -89,6 +94,7 @@ class BasicRNG {
   double beta  (double a=1.0, double b=1.0);   // Beta
 
   int bern  (double p);                     // Bernoulli
+  int binom (int n, double p);              // Binomial
 
   // CDF
   static double p_norm (double x, int use_log=0);
@@ -100,14 +106,207 @@ class BasicRNG {
   // Utility
   static double Gamma (double x, int use_log=0);
 
-}; // BasicRNG
+}; // GRNG
 
-#endif
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+inline GRNG::GRNG()
+{
+  r = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set (r, time(NULL));
+}
+
+inline GRNG::GRNG(unsigned long seed)
+{
+  r = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set (r, seed);
+}
+
+inline GRNG::GRNG(const GRNG& rng)
+{
+  r = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_memcpy(r, rng.r );
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Assignment= //
+//////////////////////////////////////////////////////////////////////
+
+inline GRNG& GRNG::operator=(const GRNG& rng)
+{
+  // The random number generators must be of the same type.
+  gsl_rng_memcpy(r, rng.r );
+  return *this;
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Read / Write //
+//////////////////////////////////////////////////////////////////////
+
+inline bool GRNG::read(const string& filename)
+{
+
+  FILE *file;
+  file = fopen(filename.c_str(), "r");
+  if (file==NULL) return false;
+  // Must be initialized to same type.  gsl_rng_free(r);
+  int success = gsl_rng_fread(file, r);
+  fclose(file);
+  return success==0;
+} // Read
+
+inline bool GRNG::write(const string& filename){
+  FILE *file;
+  file = fopen(filename.c_str(), "w");
+  int success = gsl_rng_fwrite(file, r);
+  fclose(file);
+  return success==0;
+} // Write
+
+inline void GRNG::set(unsigned long seed)
+{
+  gsl_rng_set(r, seed);
+} // Set
+
+//////////////////////////////////////////////////////////////////////
+		      // GSL Random Variates //
+//////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------
+// Distributions with one parameter.
+
+#define ONEP(NAME, CALL, P1)			\
+  inline double GRNG::NAME(double P1)		\
+  {						\
+    return CALL (r, P1);			\
+  }						\
+
+ONEP(expon_mean, gsl_ran_exponential, mean)
+ONEP(chisq,  gsl_ran_chisq      , df  )
+ONEP(norm,   gsl_ran_gaussian   , sd  )
+
+#undef ONEP
+
+//--------------------------------------------------------------------
+// Distributions with two parameters.
+
+#define TWOP(NAME, CALL, P1, P2)			\
+  inline double GRNG::NAME(double P1, double P2)	\
+  {							\
+    return CALL (r, P1, P2);				\
+  }							\
+
+TWOP(gamma_scale, gsl_ran_gamma, shape, scale)
+TWOP(flat , gsl_ran_flat , a    , b    )
+TWOP(beta , gsl_ran_beta , a    , b    )
+
+// x ~ Gamma(shape=a, scale=b)
+// x ~ x^{a-1} exp(x / b).
+
+#undef TWOP
+
+//////////////////////////////////////////////////////////////////////
+		     // Custom Random Variates //
+//////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------
+			   // Bernoulli //
+
+inline int GRNG::bern(double p)
+{
+  return gsl_ran_bernoulli(r, p);
+}
+
+//--------------------------------------------------------------------
+			   // Binomial //
+
+inline int GRNG::binom(int n, double p)
+{
+  return gsl_ran_binomial(r, p, n);
+}
+
+//--------------------------------------------------------------------
+			    // Uniform //
+
+inline double GRNG::unif()
+{
+  return gsl_rng_uniform(r);
+} // unif
+
+// The Mersenne Twister returns all 32 bits.
+inline uint32_t GRNG::bits32()
+{
+  return (uint32_t)gsl_rng_get(r);
+} // bits32
+
+//--------------------------------------------------------------------
+			  // Exponential //
+inline double GRNG::expon_rate(double rate)
+{
+  return expon_mean(1.0 / rate);
+}
+
+//--------------------------------------------------------------------
+			    // Normal //
+
+inline double GRNG::norm(double mean, double sd)
+{
+  return mean + gsl_ran_gaussian(r, sd);
+} // norm
+
+//--------------------------------------------------------------------
+			   // Gamma_Rate //
+
+inline double GRNG::gamma_rate(double shape, double rate)
+{
+  return gamma_scale(shape, 1.0 / rate);
+}
+
+//--------------------------------------------------------------------
+			   // Inv-Gamma //
+
+// a = shape, b = scale
+// x ~ IG(shape, scale) ~ x^{-a-1} exp(b / x).
+// => 1/x ~ Ga(shape, 1/scale).
+
+inline double GRNG::igamma(double shape, double scale)
+{
+  return 1.0/gsl_ran_gamma_knuth(r, shape, 1.0/scale);
+} // igamma
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline double GRNG::p_norm(double x, int use_log)
+{
+  double m = gsl_cdf_ugaussian_P(x);
+  if (use_log) m = log(m);
+  return m;
+}
+
+inline double GRNG::p_gamma_rate(double x, double shape, double rate, int use_log)
+{
+  double scale = 1.0 / rate;
+  double y = gsl_cdf_gamma_P(x, shape, scale);
+  if (use_log) y = log(y);
+  return y;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
-				 // APPENDIX //
+
+inline double GRNG::Gamma(double x, int use_log)
+{
+  double y = gsl_sf_lngamma(x);
+  if (!use_log) y = exp(y);
+  return y;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
-// If you make everything inline within the same translation unit then that
-// function will not be callable from anohter translation unit.  You can see
-// that the function is missing by using the nm command.
+inline double GRNG::d_beta(double x, double a, double b)
+{
+  return gsl_ran_beta_pdf(x, a, b);
+}
+
+#endif
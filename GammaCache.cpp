@@ -0,0 +1,122 @@
+// -*- c-basic-offset: 4; -*-
+#include "GammaCache.hpp"
+#include "RNG.hpp"
+#include <string.h>
+#include <limits>
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+GammaCache::GammaCache()
+{
+    clear();
+}
+
+void GammaCache::clear()
+{
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    base = nan;
+    lg_int.clear();
+    lg_half.clear();
+    for (int i = 0; i < NSLOT; i++) {
+	lg_key[i] = nan;
+	pg_key[i][0] = nan;
+	pg_key[i][1] = nan;
+	pg_key[i][2] = nan;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Hashing //
+//////////////////////////////////////////////////////////////////////
+
+int GammaCache::slot(double x)
+{
+    unsigned int w[2];
+    memcpy(w, &x, sizeof(double));
+    unsigned int h = (w[0] ^ w[1]) * 2654435761u;
+    return (int)(h >> 26) % NSLOT;
+}
+
+int GammaCache::slot(double x, double a, double b)
+{
+    unsigned int w[6];
+    memcpy(w  , &x, sizeof(double));
+    memcpy(w+2, &a, sizeof(double));
+    memcpy(w+4, &b, sizeof(double));
+    unsigned int h = 0;
+    for (int i = 0; i < 6; i++)
+	h = (h ^ w[i]) * 2654435761u;
+    return (int)(h >> 26) % NSLOT;
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // Log Gamma //
+//////////////////////////////////////////////////////////////////////
+
+double GammaCache::lgamma(double x)
+{
+    int i = slot(x);
+    if (lg_key[i] != x) {
+	lg_key[i] = x;
+	lg_val[i] = BasicRNG::Gamma(x, true);
+    }
+    return lg_val[i];
+}
+
+void GammaCache::rebase(double base_)
+{
+    base = base_;
+    lg_int.clear();
+    lg_half.clear();
+}
+
+void GammaCache::extend(int k)
+{
+    int j = lg_int.size();
+    if (k < j) return;
+
+    lg_int.resize(k+1);
+    lg_half.resize(k+1);
+    for (; j <= k; j++) {
+	if (j % ANCHOR == 0) {
+	    lg_int[j]  = BasicRNG::Gamma(base + j, true);
+	    lg_half[j] = BasicRNG::Gamma(base + j + 0.5, true);
+	}
+	else {
+	    lg_int[j]  = lg_int[j-1]  + log(base + j - 1);
+	    lg_half[j] = lg_half[j-1] + log(base + j - 0.5);
+	}
+    }
+}
+
+double GammaCache::lgamma(double base_, int k)
+{
+    if (base_ != base) rebase(base_);
+    extend(k);
+    return lg_int[k];
+}
+
+double GammaCache::lgamma_half(double base_, int k)
+{
+    if (base_ != base) rebase(base_);
+    extend(k);
+    return lg_half[k];
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Gamma CDF //
+//////////////////////////////////////////////////////////////////////
+
+double GammaCache::p_gamma_rate(double x, double shape, double rate, int use_log)
+{
+    int i = slot(x, shape, rate);
+    if (pg_key[i][0] != x || pg_key[i][1] != shape || pg_key[i][2] != rate) {
+	pg_key[i][0] = x;
+	pg_key[i][1] = shape;
+	pg_key[i][2] = rate;
+	pg_val[i]    = BasicRNG::p_gamma_rate(x, shape, rate);
+    }
+    return use_log ? log(pg_val[i]) : pg_val[i];
+}
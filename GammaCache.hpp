@@ -0,0 +1,86 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Memoized log gamma and gamma CDF.
+
+  In hierarchical models the same shapes show up over and over, and
+  right_tgamma_beta needs lgamma(a+k) for k = 1, 2, ....  GammaCache
+  keeps
+
+  - a table of lgamma(base + k) and lgamma(base + k + 1/2), filled with
+    the recurrence lgamma(a+1) = lgamma(a) + log(a) and re-anchored
+    every ANCHOR entries so that rounding does not accumulate;
+
+  - small direct mapped memos of lgamma(x) and p_gamma_rate(x, a, b).
+
+  A GammaCache is not locked.  It is meant to be owned by one thread,
+  which is how RNG uses it: every RNG, and so every RNGPar stream, has
+  its own.
+
+*********************************************************************/
+
+#ifndef __GAMMACACHE__
+#define __GAMMACACHE__
+
+#include <vector>
+
+class GammaCache {
+
+ public:
+
+  GammaCache();
+
+  // lgamma(x), memoized.
+  double lgamma(double x);
+
+  // lgamma(base + k) and lgamma(base + k + 0.5) for k >= 0.
+  double lgamma(double base, int k);
+  double lgamma_half(double base, int k);
+
+  // p_gamma_rate(x, shape, rate, use_log), memoized.
+  double p_gamma_rate(double x, double shape, double rate, int use_log=0);
+
+  void clear();
+
+ protected:
+
+  static const int ANCHOR = 256;
+  static const int NSLOT  = 64;
+
+  // Offset tables for the current base.
+  double base;
+  std::vector<double> lg_int;
+  std::vector<double> lg_half;
+
+  void rebase(double base_);
+  void extend(int k);
+
+  // Direct mapped memos.  Keys start as NaN so nothing matches.
+  double lg_key[NSLOT];
+  double lg_val[NSLOT];
+
+  double pg_key[NSLOT][3];
+  double pg_val[NSLOT];
+
+  static int slot(double x);
+  static int slot(double x, double a, double b);
+
+}; // GammaCache
+
+#endif
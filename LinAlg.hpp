@@ -0,0 +1,49 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+//////////////////////////////////////////////////////////////////////
+
+// The Fortran BLAS and LAPACK routines we use.  Link with -llapack -lblas.
+// All matrices are column-major.
+
+//////////////////////////////////////////////////////////////////////
+
+#ifndef __LINALG__
+#define __LINALG__
+
+extern "C" {
+
+  // BLAS
+
+  void dtrmm_(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+	      double* alpha, double* a, int* lda, double* b, int* ldb);
+
+  void dtrsm_(char* side, char* uplo, char* transa, char* diag, int* m, int* n,
+	      double* alpha, double* a, int* lda, double* b, int* ldb);
+
+  void dgemm_(char* transa, char* transb, int* m, int* n, int* k,
+	      double* alpha, double* a, int* lda, double* b, int* ldb,
+	      double* beta, double* c, int* ldc);
+
+  // LAPACK
+
+  void dpotrf_(char* uplo, int* n, double* a, int* lda, int* info);
+  void dpotri_(char* uplo, int* n, double* a, int* lda, int* info);
+
+}
+
+#endif
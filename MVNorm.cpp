@@ -0,0 +1,133 @@
+// -*- c-basic-offset: 4; -*-
+#include "MVNorm.hpp"
+#include "LinAlg.hpp"
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+MVNorm::MVNorm()
+    : n(0)
+    , prec(false)
+{
+    // Do nothing.
+}
+
+MVNorm::MVNorm(const double* A, int d, bool precision)
+    : n(0)
+    , prec(precision)
+{
+    factor(A, d);
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Factor //
+//////////////////////////////////////////////////////////////////////
+
+bool MVNorm::factor(const double* A, int d)
+{
+    L.assign(A, A + d*d);
+
+    char uplo = 'L';
+    int  info = 0;
+    dpotrf_(&uplo, &d, &L[0], &d, &info);
+
+    if (info != 0) {
+	fprintf(stderr, "MVNorm: matrix is not positive definite, info=%i.\n", info);
+	// Do not leave a partial factor for chol().
+	L.clear();
+	n = 0;
+	return false;
+    }
+
+    // dpotrf leaves the upper triangle alone.
+    for (int j = 1; j < d; j++)
+	for (int i = 0; i < j; i++)
+	    L[j*d+i] = 0.0;
+
+    n = d;
+    return true;
+}
+
+bool MVNorm::set_cov(const double* V, int d)
+{
+    prec = false;
+    return factor(V, d);
+}
+
+bool MVNorm::set_prec(const double* P, int d)
+{
+    prec = true;
+    return factor(P, d);
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Draw //
+//////////////////////////////////////////////////////////////////////
+
+void MVNorm::draw(RNG& r, double* X, int K, const double* mean) const
+{
+    if (n == 0) {
+	fprintf(stderr, "MVNorm::draw: no covariance or precision set.\n");
+	return;
+    }
+
+    int    d     = n;
+    int    dK    = d * K;
+    double one   = 1.0;
+    char   side  = 'L';
+    char   uplo  = 'L';
+    char   trans = prec ? 'T' : 'N';
+    char   diag  = 'N';
+    double* Lp   = const_cast<double*>(&L[0]);
+
+    for (int i = 0; i < dK; i++)
+	X[i] = r.norm(1.0);
+
+    if (prec)
+	dtrsm_(&side, &uplo, &trans, &diag, &d, &K, &one, Lp, &d, X, &d);
+    else
+	dtrmm_(&side, &uplo, &trans, &diag, &d, &K, &one, Lp, &d, X, &d);
+
+    if (mean)
+	for (int k = 0; k < K; k++)
+	    for (int i = 0; i < d; i++)
+		X[k*d+i] += mean[i];
+}
+
+void MVNorm::draw_canonical(RNG& r, double* X, int K, const double* b) const
+{
+    if (n == 0) {
+	fprintf(stderr, "MVNorm::draw_canonical: no covariance or precision set.\n");
+	return;
+    }
+
+    int    d    = n;
+    int    one_ = 1;
+    double one  = 1.0;
+    char   side = 'L';
+    char   uplo = 'L';
+    char   notr = 'N';
+    char   tr   = 'T';
+    char   diag = 'N';
+    double* Lp  = const_cast<double*>(&L[0]);
+
+    std::vector<double> w(b, b + d);
+
+    if (!prec) {
+	// m = L L' b, then X = m + L Z.
+	dtrmm_(&side, &uplo, &tr  , &diag, &d, &one_, &one, Lp, &d, &w[0], &d);
+	dtrmm_(&side, &uplo, &notr, &diag, &d, &one_, &one, Lp, &d, &w[0], &d);
+	draw(r, X, K, &w[0]);
+	return;
+    }
+
+    // w = L^{-1} b, X = L^{-T} (w + Z).
+    dtrsm_(&side, &uplo, &notr, &diag, &d, &one_, &one, Lp, &d, &w[0], &d);
+
+    for (int k = 0; k < K; k++)
+	for (int i = 0; i < d; i++)
+	    X[k*d+i] = w[i] + r.norm(1.0);
+
+    dtrsm_(&side, &uplo, &tr, &diag, &d, &K, &one, Lp, &d, X, &d);
+}
@@ -0,0 +1,79 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Multivariate normal draws.
+
+  MVNorm holds the lower Cholesky factor L of either the covariance,
+  V = L L', or the precision, P = L L'.  Set it once and draw as many
+  times as you like; the factorization is not repeated.
+
+  K draws at once fill a d x K block with iid normals and then apply
+  one level 3 BLAS call to the whole block:
+
+    covariance : X = m + L Z            (dtrmm)
+    precision  : X = m + L^{-T} Z       (dtrsm)
+
+  In Bayesian regression the posterior comes in canonical form,
+  N(P^{-1} b, P^{-1}).  draw_canonical handles it with the precision
+  factor and two triangular solves, X = L^{-T} (L^{-1} b + Z).
+
+  X, V, P, m, and b are column-major double arrays.
+
+*********************************************************************/
+
+#ifndef __MVNORM__
+#define __MVNORM__
+
+#include "RNG.hpp"
+#include <vector>
+
+class MVNorm {
+
+ protected:
+
+  int  n;       // Dimension.
+  bool prec;    // Is L the factor of the precision?
+  std::vector<double> L;
+
+  bool factor(const double* A, int d);
+
+ public:
+
+  MVNorm();
+  MVNorm(const double* A, int d, bool precision=false);
+
+  // Factor and cache.  Return false if A is not positive definite.
+  bool set_cov (const double* V, int d);
+  bool set_prec(const double* P, int d);
+
+  int  dim() const { return n; }
+  bool is_prec() const { return prec; }
+
+  // Lower triangular factor, d x d; NULL before a set or after one fails.
+  const double* chol() const { return L.empty() ? 0 : &L[0]; }
+
+  // X (d x K) ~ N(mean, V) or N(mean, P^{-1}).  mean may be NULL.
+  void draw(RNG& r, double* X, int K, const double* mean=0) const;
+
+  // X (d x K) ~ N(P^{-1} b, P^{-1}) or N(V b, V).
+  void draw_canonical(RNG& r, double* X, int K, const double* b) const;
+
+}; // MVNorm
+
+#endif
@@ -0,0 +1,222 @@
+// -*- c-basic-offset: 4; -*-
+#include "MapSink.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <cstdio>
+
+static size_t map_elsize(int dtype)
+{
+    switch (dtype) {
+    case MAP_FLOAT32: return 4;
+    case MAP_FLOAT64: return 8;
+    case MAP_INT32  : return 4;
+    default         : return 0;
+    }
+}
+
+// Blocks are mapped on their own, so the draws start on a page and each
+// block is whole pages.
+static size_t map_page()
+{
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? page : 4096;
+}
+
+//////////////////////////////////////////////////////////////////////
+			       // Sink //
+//////////////////////////////////////////////////////////////////////
+
+MapSink::MapSink()
+    : fd(-1)
+    , hdr(NULL)
+    , win(NULL)
+    , winbytes(0)
+    , pos(0)
+{
+    // Do nothing.
+}
+
+MapSink::~MapSink()
+{
+    close();
+}
+
+bool MapSink::open(const char* path, uint64_t count, int dtype, const char* engine,
+		   unsigned long seed, int nstream, uint64_t block)
+{
+    close();
+
+    size_t size = map_elsize(dtype);
+    if (size == 0 || nstream < 1 || !engine) {
+	fprintf(stderr, "MapSink::open: dtype=%i, nstream=%i.\n", dtype, nstream);
+	return false;
+    }
+
+    size_t   data = map_page();
+    uint64_t page = data / size;
+    if (block == 0) block = MAP_BLOCK;
+    block = ((block + page - 1) / page) * page;
+
+    fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+	fprintf(stderr, "MapSink::open: cannot create %s.\n", path);
+	return false;
+    }
+
+    if (ftruncate(fd, data + count * size) != 0) {
+	fprintf(stderr, "MapSink::open: cannot size %s.\n", path);
+	::close(fd);
+	fd = -1;
+	return false;
+    }
+
+    void* p = mmap(NULL, data, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+	fprintf(stderr, "MapSink::open: cannot map %s.\n", path);
+	::close(fd);
+	fd = -1;
+	return false;
+    }
+
+    hdr = (MapHeader*)p;
+    memset(hdr, 0, data);
+    memcpy(hdr->magic, MAP_MAGIC, sizeof(MAP_MAGIC));
+    strncpy(hdr->engine, engine, sizeof(hdr->engine) - 1);
+    hdr->version = MAP_VERSION;
+    hdr->dtype   = dtype;
+    hdr->elsize  = size;
+    hdr->nstream = nstream;
+    hdr->seed    = seed;
+    hdr->count   = count;
+    hdr->block   = block;
+    hdr->written = 0;
+    hdr->data    = data;
+
+    pos = 0;
+    return true;
+}
+
+void MapSink::unmap_block()
+{
+    if (!win) return;
+    munmap(win, winbytes);
+    win      = NULL;
+    winbytes = 0;
+    hdr->written = pos;
+}
+
+void* MapSink::next(size_t& n)
+{
+    n = 0;
+    if (!hdr) return NULL;
+
+    unmap_block();
+    if (pos >= hdr->count) return NULL;
+
+    uint64_t len   = hdr->count - pos;
+    if (len > hdr->block) len = hdr->block;
+    size_t   bytes = len * hdr->elsize;
+
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   hdr->data + pos * hdr->elsize);
+    if (p == MAP_FAILED) {
+	fprintf(stderr, "MapSink::next: cannot map draws %lu to %lu.\n",
+		(unsigned long)pos, (unsigned long)(pos + len));
+	return NULL;
+    }
+
+    // Written once, front to back.
+    madvise(p, bytes, MADV_SEQUENTIAL);
+
+    win      = (char*)p;
+    winbytes = bytes;
+    pos     += len;
+    n        = len;
+    return p;
+}
+
+void MapSink::close()
+{
+    if (!hdr) return;
+    unmap_block();
+    size_t data = hdr->data;
+    msync(hdr, data, MS_SYNC);
+    munmap(hdr, data);
+    ::close(fd);
+    hdr = NULL;
+    fd  = -1;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Source //
+//////////////////////////////////////////////////////////////////////
+
+MapSource::MapSource()
+    : hdr(NULL)
+    , bytes(0)
+{
+    // Do nothing.
+}
+
+MapSource::MapSource(const char* path)
+    : hdr(NULL)
+    , bytes(0)
+{
+    open(path);
+}
+
+MapSource::~MapSource()
+{
+    close();
+}
+
+bool MapSource::open(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+	fprintf(stderr, "MapSource::open: cannot open %s.\n", path);
+	return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MapHeader)) {
+	fprintf(stderr, "MapSource::open: %s is too short.\n", path);
+	::close(fd);
+	return false;
+    }
+
+    void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+	fprintf(stderr, "MapSource::open: cannot map %s.\n", path);
+	return false;
+    }
+
+    hdr   = (MapHeader*)p;
+    bytes = st.st_size;
+
+    if (memcmp(hdr->magic, MAP_MAGIC, sizeof(MAP_MAGIC)) != 0 || hdr->version != MAP_VERSION
+	|| hdr->data < sizeof(MapHeader) || bytes < hdr->data + hdr->count * hdr->elsize) {
+	fprintf(stderr, "MapSource::open: %s is not a MapSink file.\n", path);
+	close();
+	return false;
+    }
+
+    if (hdr->written < hdr->count)
+	fprintf(stderr, "MapSource::open: %s is incomplete, %lu of %lu draws.\n", path,
+		(unsigned long)hdr->written, (unsigned long)hdr->count);
+
+    return true;
+}
+
+void MapSource::close()
+{
+    if (hdr) munmap(hdr, bytes);
+    hdr   = NULL;
+    bytes = 0;
+}
@@ -0,0 +1,166 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Draws streamed to a memory mapped binary file.
+
+  MapSink makes a file for count draws and hands out one block of it
+  at a time, mapped into memory, so any array sampler, e.g. those of
+  RNGPar, writes straight into the file:
+
+    RNGPar<double> par(nthread, seed);
+    MapSink out;
+    out.open<double>("draws.bin", N, par.engine(), par.get_seed(), par.size());
+    size_t n;
+    while (double* b = out.next<double>(n))
+      par.norm(b, n, mean, sd, 1);
+    out.close();
+
+  Only the current block is mapped; the kernel writes the earlier ones
+  back, so the file may be much bigger than memory.  Parameters are
+  recycled within a block, so use one value, or a block size that is a
+  multiple of the number of parameters.  The default block is 1M
+  draws, rounded to whole pages of this machine.
+
+  The file is a MapHeader padded to one page, whose size is recorded
+  as data, and then the draws in native byte order.  The header
+  records the type of the draws, the engine named by the caller, the
+  seed, and the number of streams.  Stream offsets are not stored:
+  RNGPar seeds stream i with seed + i, so seed and nstream give them.
+  written is the number of draws in whole blocks handed back, and
+  equals count once the file is complete.
+
+  MapSource maps a finished file read only, for use in place.
+
+*********************************************************************/
+
+#ifndef __MAPSINK__
+#define __MAPSINK__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MAP_MAGIC     "RNGMAP1"
+#define MAP_VERSION   2
+#define MAP_BLOCK     (1 << 20)
+
+enum MapDType {MAP_NONE=0, MAP_FLOAT32=1, MAP_FLOAT64=2, MAP_INT32=3};
+
+template<typename T> struct MapType { static const int code = MAP_NONE; };
+template<> struct MapType<float>    { static const int code = MAP_FLOAT32; };
+template<> struct MapType<double>   { static const int code = MAP_FLOAT64; };
+template<> struct MapType<int32_t>  { static const int code = MAP_INT32; };
+
+struct MapHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t dtype;
+  uint32_t elsize;
+  uint32_t nstream;
+  uint64_t seed;
+  uint64_t count;               // Draws in the file.
+  uint64_t block;               // Draws per block.
+  uint64_t written;             // Draws in finished blocks.
+  uint64_t data;                // Offset of the draws, one page.
+  char     engine[32];          // Truncated to 31 characters.
+};
+
+//////////////////////////////////////////////////////////////////////
+			       // Sink //
+//////////////////////////////////////////////////////////////////////
+
+class MapSink {
+
+ protected:
+
+  int        fd;
+  MapHeader* hdr;
+  char*      win;               // The current block.
+  size_t     winbytes;
+  uint64_t   pos;               // Draws handed out.
+
+  void unmap_block();
+
+  // Not copyable: owns the mapping.
+  MapSink(const MapSink&);
+  MapSink& operator=(const MapSink&);
+
+ public:
+
+  MapSink();
+  ~MapSink();
+
+  // engine names the generator for the header, e.g. RNGPar::engine().
+  bool open(const char* path, uint64_t count, int dtype, const char* engine,
+	    unsigned long seed=0, int nstream=1, uint64_t block=0);
+
+  template<typename T>
+  bool open(const char* path, uint64_t count, const char* engine,
+	    unsigned long seed=0, int nstream=1, uint64_t block=0)
+  { return open(path, count, MapType<T>::code, engine, seed, nstream, block); }
+
+  // Map the next block and set n to its length.  NULL when done.
+  void* next(size_t& n);
+
+  template<typename T>
+  T* next(size_t& n) { return (T*)next(n); }
+
+  // Unmap, finish the header, and close.
+  void close();
+
+  bool is_open() const { return hdr != 0; }
+
+}; // MapSink
+
+//////////////////////////////////////////////////////////////////////
+			      // Source //
+//////////////////////////////////////////////////////////////////////
+
+class MapSource {
+
+ protected:
+
+  MapHeader* hdr;
+  size_t     bytes;
+
+  MapSource(const MapSource&);
+  MapSource& operator=(const MapSource&);
+
+ public:
+
+  MapSource();
+  MapSource(const char* path);
+  ~MapSource();
+
+  bool open(const char* path);
+  void close();
+
+  const MapHeader* header() const { return hdr; }
+  uint64_t size() const { return hdr ? hdr->written : 0; }
+
+  // NULL unless the file holds T.
+  template<typename T>
+  const T* data() const
+  {
+    if (!hdr || hdr->dtype != (uint32_t)MapType<T>::code) return 0;
+    return (const T*)((const char*)hdr + hdr->data);
+  }
+
+}; // MapSource
+
+#endif
@@ -0,0 +1,154 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Contiguous storage behind a Mat.
+
+  The Mat fillers of RNG write through a double* when the container
+  has one, and through M(i) otherwise.  mat_ptr(M) finds the pointer
+  from the first of
+
+    double* data()      std::vector, Eigen, Blitz, RNGSpan
+    double* getp()      Matrix
+    double* memptr()    Armadillo
+
+  and returns NULL if there is none.  A type whose pointer does not
+  cover M.size() consecutive doubles must say so,
+
+    template<> struct MatStorage<MyView> { enum {kind = MAT_ELEM}; };
+
+  Eigen's expressions with data() also have innerStride(), which is
+  checked at run time: a row of a column major matrix is not
+  contiguous and goes through M(i).
+
+  RNGSpan wraps a pointer and a length, so any buffer can be passed
+  as a Mat.  Sizes and indices are size_t throughout.
+
+*********************************************************************/
+
+#ifndef __MATSTORAGE__
+#define __MATSTORAGE__
+
+#include <stddef.h>
+
+enum MatKind {MAT_ELEM=0, MAT_DATA=1, MAT_GETP=2, MAT_MEMPTR=3};
+
+// Whether U has the member; a call that does not compile removes the
+// first overload.
+
+struct MatProbe {
+  typedef char yes;
+  struct no { char c[2]; };
+  template<int N> struct sized {};
+  static yes is_ptr(double*);
+  static yes is_int(long);
+};
+
+#define MAT_HAS(NAME, MEMBER, CHECK)					\
+  template<typename Mat> class NAME {					\
+    template<typename U> static MatProbe::yes				\
+      test(MatProbe::sized<sizeof(MatProbe::CHECK(((U*)0)->MEMBER()))>*); \
+    template<typename U> static MatProbe::no test(...);		\
+  public:								\
+    enum {value = sizeof(test<Mat>(0)) == sizeof(MatProbe::yes)};	\
+  };									\
+
+MAT_HAS(MatHasData  , data       , is_ptr)
+MAT_HAS(MatHasGetp  , getp       , is_ptr)
+MAT_HAS(MatHasMemptr, memptr     , is_ptr)
+MAT_HAS(MatHasStride, innerStride, is_int)
+
+#undef MAT_HAS
+
+template<typename Mat> struct MatStorage {
+  enum {kind = MatHasData<Mat>::value ? MAT_DATA
+	: MatHasGetp<Mat>::value ? MAT_GETP
+	: MatHasMemptr<Mat>::value ? MAT_MEMPTR : MAT_ELEM};
+};
+
+//////////////////////////////////////////////////////////////////////
+			     // Pointer //
+//////////////////////////////////////////////////////////////////////
+
+template<int K> struct MatTag {};
+
+template<typename Mat> inline bool mat_dense(const Mat&, MatTag<0>) { return true; }
+template<typename Mat> inline bool mat_dense(const Mat& M, MatTag<1>)
+{ return M.innerStride() == 1 && (M.outerSize() <= 1 || M.outerStride() == M.innerSize()); }
+
+template<typename Mat> inline double* mat_ptr(Mat&  , MatTag<MAT_ELEM>  ) { return 0; }
+template<typename Mat> inline double* mat_ptr(Mat& M, MatTag<MAT_GETP>  ) { return M.getp(); }
+template<typename Mat> inline double* mat_ptr(Mat& M, MatTag<MAT_MEMPTR>) { return M.memptr(); }
+template<typename Mat> inline double* mat_ptr(Mat& M, MatTag<MAT_DATA>  )
+{
+  if (M.size() == 0 || !mat_dense(M, MatTag<MatHasStride<Mat>::value>())) return 0;
+  return M.data();
+}
+
+template<typename Mat> inline double* mat_ptr(Mat& M)
+{ return mat_ptr(M, MatTag<MatStorage<Mat>::kind>()); }
+
+// Read only.  Some containers only have the non-const accessor.
+template<typename Mat> inline const double* mat_ptr(const Mat& M)
+{ return mat_ptr(const_cast<Mat&>(M)); }
+
+// Read a parameter through the pointer when there is one.
+template<typename Mat> class MatIn {
+  const Mat&    M;
+  const double* p;
+  size_t        n;
+ public:
+  MatIn(const Mat& M_) : M(M_), p(mat_ptr(M_)), n(M_.size()) {}
+  double operator[](size_t i) const { return p ? p[i] : M(i); }
+  size_t size() const { return n; }
+};
+
+//////////////////////////////////////////////////////////////////////
+			       // Span //
+//////////////////////////////////////////////////////////////////////
+
+class RNGSpan {
+  double* p;
+  size_t  n;
+ public:
+  RNGSpan(double* p_, size_t n_) : p(p_), n(n_) {}
+  double&       operator()(size_t i)       { return p[i]; }
+  const double& operator()(size_t i) const { return p[i]; }
+  double*       data()       { return p; }
+  const double* data() const { return p; }
+  size_t        size() const { return n; }
+};
+
+// Fill M with EXPR, a function of i.
+#define MAT_FILL(M, EXPR)						\
+  do {									\
+    size_t  n_ = (M).size();						\
+    double* x_ = mat_ptr(M);						\
+    if (x_) for (size_t i = 0; i < n_; i++) x_[i] = (EXPR);		\
+    else    for (size_t i = 0; i < n_; i++) (M)(i) = (EXPR);		\
+  } while (0)								\
+
+// Copy len values of Y to M, starting at start; x is mat_ptr(M).
+template<typename Mat, typename T>
+inline void mat_store(Mat& M, double* x, size_t start, const T* Y, size_t len)
+{
+  if (x) for (size_t j = 0; j < len; j++) x[start+j] = Y[j];
+  else   for (size_t j = 0; j < len; j++) M(start+j) = Y[j];
+}
+
+#endif
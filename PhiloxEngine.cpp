@@ -0,0 +1,143 @@
+// -*- c-basic-offset: 4; -*-
+#include "PhiloxEngine.hpp"
+#include "RNGImpl.hpp"
+
+//////////////////////////////////////////////////////////////////////
+			   // One Stream //
+//////////////////////////////////////////////////////////////////////
+
+PhiloxEngine::PhiloxEngine(unsigned long seed, uint64_t stream_, uint64_t block_)
+{
+    pctr[2] = (uint32_t)stream_;
+    pctr[3] = (uint32_t)(stream_ >> 32);
+    set(seed);
+    seek(block_);
+}
+
+void PhiloxEngine::set(unsigned long seed)
+{
+    pkey[0] = (uint32_t)seed;
+    pkey[1] = (uint32_t)((uint64_t)seed >> 32);
+    seek(0);
+}
+
+void PhiloxEngine::seek(uint64_t block_)
+{
+    pctr[0] = (uint32_t)block_;
+    pctr[1] = (uint32_t)(block_ >> 32);
+    used    = 4;
+}
+
+template class RNGT<PhiloxEngine>;
+
+//////////////////////////////////////////////////////////////////////
+			   // Many Streams //
+//////////////////////////////////////////////////////////////////////
+
+PhiloxStreams::PhiloxStreams(size_t nstream, unsigned long seed, uint64_t first_stream)
+    : n(nstream)
+    , first(first_stream)
+    , lo(nstream, 0)
+    , hi(nstream, 0)
+{
+    set(seed);
+}
+
+void PhiloxStreams::set(unsigned long seed)
+{
+    pkey[0] = (uint32_t)seed;
+    pkey[1] = (uint32_t)((uint64_t)seed >> 32);
+    std::fill(lo.begin(), lo.end(), 0);
+    std::fill(hi.begin(), hi.end(), 0);
+}
+
+// LANES streams at a time, round by round, so that each round is one
+// short loop across the lanes that the compiler can turn into vector
+// instructions.
+
+void PhiloxStreams::blocks(size_t i0, int m, uint32_t w[4][LANES])
+{
+    uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+    uint32_t k0 = pkey[0], k1 = pkey[1];
+
+    for (int j = 0; j < LANES; j++) {
+	size_t   i = i0 + (j < m ? j : 0);
+	uint64_t s = first + i;
+	c0[j] = lo[i];
+	c1[j] = hi[i];
+	c2[j] = (uint32_t)s;
+	c3[j] = (uint32_t)(s >> 32);
+    }
+
+    for (int r = 0; r < 10; r++) {
+	for (int j = 0; j < LANES; j++) {
+	    uint64_t p0 = (uint64_t)0xD2511F53u * c0[j];
+	    uint64_t p1 = (uint64_t)0xCD9E8D57u * c2[j];
+	    uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[j] ^ k0;
+	    uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[j] ^ k1;
+	    c1[j] = (uint32_t)p1;
+	    c3[j] = (uint32_t)p0;
+	    c0[j] = n0;
+	    c2[j] = n2;
+	}
+	k0 += 0x9E3779B9u;
+	k1 += 0xBB67AE85u;
+    }
+
+    for (int j = 0; j < m; j++) {
+	w[0][j] = c0[j]; w[1][j] = c1[j]; w[2][j] = c2[j]; w[3][j] = c3[j];
+	size_t i = i0 + j;
+	if (++lo[i] == 0) ++hi[i];
+    }
+}
+
+void PhiloxStreams::unif(double* U)
+{
+    uint32_t w[4][LANES];
+    for (size_t i0 = 0; i0 < n; i0 += LANES) {
+	int m = n - i0 < LANES ? (int)(n - i0) : LANES;
+	blocks(i0, m, w);
+	for (int j = 0; j < m; j++)
+	    U[i0+j] = philox_unif(w[0][j], w[1][j]);
+    }
+}
+
+void PhiloxStreams::norm(double* Z)
+{
+    uint32_t w[4][LANES];
+    for (size_t i0 = 0; i0 < n; i0 += LANES) {
+	int m = n - i0 < LANES ? (int)(n - i0) : LANES;
+	blocks(i0, m, w);
+	for (int j = 0; j < m; j++) {
+	    double u1 = philox_unif(w[0][j], w[1][j]);
+	    double u2 = philox_unif(w[2][j], w[3][j]);
+	    Z[i0+j] = sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+	}
+    }
+}
+
+void PhiloxStreams::expon(double* E)
+{
+    uint32_t w[4][LANES];
+    for (size_t i0 = 0; i0 < n; i0 += LANES) {
+	int m = n - i0 < LANES ? (int)(n - i0) : LANES;
+	blocks(i0, m, w);
+	for (int j = 0; j < m; j++)
+	    E[i0+j] = -log(philox_unif(w[0][j], w[1][j]));
+    }
+}
+
+PhiloxRNG PhiloxStreams::chain(size_t i) const
+{
+    unsigned long seed = (unsigned long)(pkey[0] | ((uint64_t)pkey[1] << 32));
+    PhiloxRNG r(seed, first + i);
+    r.seek(lo[i] | ((uint64_t)hi[i] << 32));
+    return r;
+}
+
+void PhiloxStreams::resume(size_t i, const PhiloxRNG& r)
+{
+    uint64_t b = r.block();
+    lo[i] = (uint32_t)b;
+    hi[i] = (uint32_t)(b >> 32);
+}
@@ -0,0 +1,181 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Philox4x32-10 streams: many small, independent generators.
+
+  Philox (Salmon, Moraes, Dror, and Shaw, 2011) is counter based.
+  Block c of stream s under seed k is a ten round bijection of the 128
+  bit counter (c, s) keyed by k, so a stream is nothing more than its
+  64 bit block count; there is no table of state to carry around.
+
+  PhiloxEngine is one stream, 44 bytes against MT19937's 2.5 KB, and
+  PhiloxRNG = RNGT<PhiloxEngine> has every sampler on it.  Each block
+  gives four 32 bit words and a uniform uses two, (53 bits + 1/2) /
+  2^53, so it is never 0 or 1.  PhiloxRNG also carries RNGT's caches,
+  a few KB, so it is not the thing to keep one of per chain.
+
+  PhiloxStreams keeps n streams as arrays of block counts, 8 bytes a
+  stream, for running thousands of chains side by side.
+  unif, norm, and expon advance every stream by one block and write one
+  variate per stream.  The loop over streams is plain 32 bit integer
+  arithmetic on contiguous arrays, 16 lanes at a time, which the
+  compiler may vectorize; the Makefile builds PhiloxEngine.o with -O3
+  so that it can.
+  When a chain needs more than that, e.g. a rejection sampler, take
+  its PhiloxRNG with chain(i) and hand it back with resume(i, r); the
+  words r had buffered but not used are dropped.
+
+  Stream i of PhiloxStreams(n, seed, first) draws on the same blocks
+  as PhiloxRNG(seed, first + i), so a run can be split across
+  processes by first.
+
+*********************************************************************/
+
+#ifndef __PHILOXENGINE__
+#define __PHILOXENGINE__
+
+#include "RNG.hpp"
+#include "EngineBase.hpp"
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////
+			      // Philox //
+//////////////////////////////////////////////////////////////////////
+
+// Words 0 and 1 of ctr are the block, 2 and 3 the stream.
+inline void philox4x32(const uint32_t* ctr, const uint32_t* key, uint32_t* out)
+{
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int r = 0; r < 10; r++) {
+	uint64_t p0 = (uint64_t)0xD2511F53u * c0;
+	uint64_t p1 = (uint64_t)0xCD9E8D57u * c2;
+	uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+	uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+	c1 = (uint32_t)p1;
+	c3 = (uint32_t)p0;
+	c0 = n0;
+	c2 = n2;
+	k0 += 0x9E3779B9u;
+	k1 += 0xBB67AE85u;
+    }
+
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// Two words to a uniform in (0, 1).
+inline double philox_unif(uint32_t a, uint32_t b)
+{
+    uint64_t m = ((uint64_t)(a >> 5) << 26) | (b >> 6);
+    return (m + 0.5) * 1.1102230246251565e-16;
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // One Stream //
+//////////////////////////////////////////////////////////////////////
+
+class PhiloxEngine : public EngineBase<PhiloxEngine> {
+
+ protected:
+
+  uint32_t pkey[2];
+  uint32_t pctr[4];             // Next block, stream.
+  uint32_t pout[4];             // Current block.
+  int      used;                // Words of pout used.
+
+  void refill()
+  {
+    philox4x32(pctr, pkey, pout);
+    if (++pctr[0] == 0) ++pctr[1];
+    used = 0;
+  }
+
+ public:
+
+  // The seed defaults to the time, as GRNG's does.
+  PhiloxEngine(unsigned long seed=time(NULL), uint64_t stream=0, uint64_t block=0);
+
+  // Back to block 0 of the stream.
+  void set(unsigned long seed);
+
+  void     seek(uint64_t block);
+  uint64_t stream() const { return pctr[2] | ((uint64_t)pctr[3] << 32); }
+
+  // The next block not yet drawn from.  The rest of the current one
+  // is dropped if the stream is moved there.
+  uint64_t block() const { return pctr[0] | ((uint64_t)pctr[1] << 32); }
+
+  uint32_t bits32()
+  {
+    if (used == 4) refill();
+    return pout[used++];
+  }
+
+  double unif()
+  {
+    if (used > 2) refill();
+    double u = philox_unif(pout[used], pout[used+1]);
+    used += 2;
+    return u;
+  }
+
+}; // PhiloxEngine
+
+typedef RNGT<PhiloxEngine> PhiloxRNG;
+
+//////////////////////////////////////////////////////////////////////
+			   // Many Streams //
+//////////////////////////////////////////////////////////////////////
+
+class PhiloxStreams {
+
+ protected:
+
+  size_t   n;
+  uint64_t first;
+  uint32_t pkey[2];
+  std::vector<uint32_t> lo, hi; // Block count of each stream.
+
+  static const int LANES = 16;
+
+  // The next block of streams i0, ..., i0 + m - 1, m <= LANES, word k
+  // of stream i0 + j in w[k][j].
+  void blocks(size_t i0, int m, uint32_t w[4][LANES]);
+
+ public:
+
+  PhiloxStreams(size_t nstream, unsigned long seed, uint64_t first_stream=0);
+
+  size_t size() const { return n; }
+
+  // Back to block 0 of every stream.
+  void set(unsigned long seed);
+
+  // One variate per stream, X of length size().  Each uses one block.
+  void unif (double* U);
+  void norm (double* Z);   // Box-Muller, the cosine half.
+  void expon(double* E);   // Rate 1.
+
+  PhiloxRNG chain(size_t i) const;
+  void      resume(size_t i, const PhiloxRNG& r);
+
+}; // PhiloxStreams
+
+#endif
@@ -1,381 +1,183 @@
 // -*- c-basic-offset: 4; -*-
-#include "RNG.hpp"
-
-// #ifdef USE_R
-// #include "RRNG.cpp"
-// #else
-// #include "GRNG.cpp"
-// #endif
-
-// Throw runtime exception or return.
-#ifndef TREOR
-#ifndef NTHROW
-#define TREOR(MESS, VAL) throw std::runtime_error(MESS);
-#else
-#define TREOR(MESS, VAL) {fprintf(stderr, MESS); return VAL;}
-#endif
-#endif
-
-#ifndef RCHECK
-#define RCHECK 1000
-#endif
-
-inline void check_R_interupt(int count)
-{
-    #ifdef USE_R
-    if (count % RCHECK == 0) R_CheckUserInterrupt();
-    #endif
-}
-
-// Truncated Exponential
-double RNG::texpon_rate(double left, double rate){
-    if (rate < 0) TREOR("texpon_rate: rate < 0, return 0\n", 0.0);
-    // return left - log(unif()) / rate;
-    return expon_rate(rate) + left;
-}
-
-double RNG::texpon_rate(double left, double right, double rate)
-{
-    if (left == right) return left;
-    if (left > right) TREOR("texpon_rate: left > right, return 0.\n", 0.0);
-    if (rate < 0) TREOR("texpon_rate: rate < 0, return 0\n", 0.0);
-
-    double b = 1 - exp(rate * (left - right));
-    double y = 1 - b * unif();
-    return left - log(y) / rate;
-}
+#include "RNGImpl.hpp"
 
 //////////////////////////////////////////////////////////////////////
-	       // TRUNCATED NORMAL HELPER FUNCTIONS //
+		   // SETUP, INDEPENDENT OF ENGINE //
 //////////////////////////////////////////////////////////////////////
 
-double RNG::alphastar(double left)
-{
-    return 0.5 * (left + sqrt(left*left + 4));
-} // alphastar
+// See RNGImpl.hpp for the samplers that use these.
 
-double RNG::lowerbound(double left)
-{
-    double astar  = alphastar(left);
-    double lbound = left + exp(0.5 * + 0.5 * left * (left - astar)) / astar;
-    return lbound;
-} // lowerbound
+#define GIG_ZTOL 1e-12
 
-//////////////////////////////////////////////////////////////////////
-		     // DRAW TRUNCATED NORMAL //
-//////////////////////////////////////////////////////////////////////
-
-double RNG::tnorm(double left)
+// Mode of x^{lambda-1} exp(-0.5 omega (x + 1/x)).
+static double gig_mode(double lambda, double omega)
 {
-    double rho, ppsl;
-    int count = 1;
-
-    if (left < 0) { // Accept/Reject Normal
-        while (true) {
-            ppsl = norm(0.0, 1.0);
-            if (ppsl > left) return ppsl;
-            check_R_interupt(count++);
-            #ifndef NDEBUG
-            if (count > RCHECK * 1000) fprintf(stderr, "left < 0; count: %i\n", count);
-            #endif
-        }
-    }
-    else { // Accept/Reject Exponential
-        // return tnorm_tail(left); // Use Devroye.
-        double astar = alphastar(left);
-        while (true) {
-            ppsl = texpon_rate(left, astar);
-            rho  = exp( -0.5 * (ppsl - astar) * (ppsl - astar) );
-            if (unif() < rho) return ppsl;
-            check_R_interupt(count++);
-            #ifndef NDEBUG
-            if (count > RCHECK * 1000) fprintf(stderr, "left > 0; count: %i\n", count);
-            #endif
-        }
-    }
-} // tnorm
-//--------------------------------------------------------------------
+    if (lambda >= 1.)
+        return (sqrt((lambda-1.)*(lambda-1.) + omega*omega) + (lambda-1.)) / omega;
+    else
+        return omega / (sqrt((1.-lambda)*(1.-lambda) + omega*omega) + (1.-lambda));
+}
 
-double RNG::tnorm(double left, double right)
+bool GIGSetup::set(double lambda_, double chi_, double psi_)
 {
-    // The most difficult part of this algorithm is figuring out all the
-    // various cases.  An outline is summarized in the Appendix.
+    lambda = lambda_;
+    chi    = chi_;
+    psi    = psi_;
+    method = GIG_NONE;
 
-    // Check input
     #ifdef USE_R
-    if (ISNAN(right) || ISNAN(left))
+    if (ISNAN(lambda) || ISNAN(chi) || ISNAN(psi) ||
     #else
-    if (std::isnan(right) || std::isnan(left))
+    if (std::isnan(lambda) || std::isnan(chi) || std::isnan(psi) ||
     #endif
-	{
-	    fprintf(stderr, "Warning: nan sent to RNG::tnorm: left=%g, right=%g\n", left, right);
-	    TREOR("RNG::tnorm: parameter problem.\n", 0.5 * (left + right));
-	    // throw std::runtime_error("RNG::tnorm: parameter problem.\n");
-	}
-    
-    if (right < left) {
-        fprintf(stderr, "Warning: left: %g, right:%g.\n", left, right);
-        TREOR("RNG::tnorm: parameter problem.\n", 0.5 * (left + right));
-    }
-    
-    double rho, ppsl;
-    int count = 1;
-    
-    if (left >= 0) {
-        double lbound = lowerbound(left);
-        if (right > lbound) { // Truncated Exponential.
-            double astar = alphastar(left);
-            while (true) {
-		ppsl = texpon_rate(left, right, astar);
-                rho  = exp(-0.5*(ppsl - astar)*(ppsl-astar));
-                if (unif() < rho) return ppsl;
-		if (count > RCHECK * 10) fprintf(stderr, "left >= 0, right > lbound; count: %i\n", count);
-                // if (ppsl < right) return ppsl;
-            }
-        }
-        else {
-            while (true) {
-                ppsl = flat(left, right);
-                rho  = exp(0.5 * (left*left - ppsl*ppsl));
-                if (unif() < rho) return ppsl;
-                check_R_interupt(count++);
-                #ifndef NDEBUG
-                if (count > RCHECK * 10) fprintf(stderr, "left >= 0, right <= lbound; count: %i\n", count);
-                #endif
-            }
-        }
-    }
-    else if (right >= 0) {
-        if ( (right - left) < SQRT2PI ){
-            while (true) {
-                ppsl = flat(left, right);
-                rho  = exp(-0.5 * ppsl * ppsl);
-                if (unif() < rho) return ppsl;
-                check_R_interupt(count++);
-                #ifndef NDEBUG
-                if (count > RCHECK * 10) fprintf(stderr, "First, left < 0, right >= 0, count: %i\n", count);
-                #endif
-            }
-        }
-        else{
-            while (true) {
-                ppsl = norm(0, 1);
-                if (left < ppsl && ppsl < right) return ppsl;
-                check_R_interupt(count++);
-                #ifndef NDEBUG
-                if (count > RCHECK * 10) fprintf(stderr, "Second, left < 0, right > 0, count: %i\n", count);
-                #endif
-            }
-        }
-    }
-    else {
-        return -1. * tnorm(-1.0 * right, -1.0 * left);
+        chi < 0 || psi < 0 || (chi == 0 && lambda <= 0) || (psi == 0 && lambda >= 0)) {
+        fprintf(stderr, "GIGSetup: lambda=%g, chi=%g, psi=%g.\n", lambda, chi, psi);
+        TREOR("GIGSetup::set: parameter problem.\n", false);
     }
-} // tnorm
-//--------------------------------------------------------------------
 
-double RNG::tnorm(double left, double mu, double sd)
-{
-    double newleft = (left - mu) / sd;
-    return mu + tnorm(newleft) * sd;
-} // tnorm
-//--------------------------------------------------------------------
-
-double RNG::tnorm(double left, double right, double mu, double sd)
-{
-    if (left==right) return left;
-
-    double newleft  = (left - mu) / sd;
-    double newright = (right - mu) / sd;
-
-    // I want to check this here as well so we can see what the input was.
-    // It may be more elegant to try and catch tdraw.
-    if (newright < newleft) {
-        fprintf(stderr, "left, right, mu, sd: %g, %g, %g, %g \n", left, right, mu, sd);
-        fprintf(stderr, "nleft, nright: %g, %g\n", newleft, newright);
-        TREOR("RNG::tnorm: parameter problem.\n", 0.5 * (left + right));
+    // Basically gamma and inverse gamma.
+    if (chi < GIG_ZTOL && lambda > 0) {
+        method = GIG_GAMMA;
+        return true;
     }
-
-    double tdraw = tnorm(newleft, newright);
-    double draw = mu + tdraw * sd;
-
-    // It may be the case that there is some numerical error and that the draw
-    // ends up out of bounds.
-    if (draw < left || draw > right){
-        fprintf(stderr, "Error in tnorm: draw not in bounds.\n");
-        fprintf(stderr, "left, right, mu, sd: %g, %g, %g, %g\n", left, right, mu, sd);
-        fprintf(stderr, "nleft, nright, tdraw, draw: %g, %g, %g, %g\n", newleft, newright, tdraw, draw);
-        TREOR("Aborting and returning average of left and right.\n",  0.5 * (left + right));
+    if (psi < GIG_ZTOL && lambda < 0) {
+        method = GIG_IGAMMA;
+        return true;
     }
 
-    return draw;
-} // tnorm
-//--------------------------------------------------------------------
-
-// Right tail of normal by Devroye
-//------------------------------------------------------------------------------
-double RNG::tnorm_tail(double t)
-{
-    int count = 1;
-
-    double E1 = expon_rate(1.0);
-    double E2 = expon_rate(1.0);
-    while ( E1*E1 > 2 * E2 / t) {
-        E1 = expon_rate(1.0);
-        E2 = expon_rate(1.0);
-        check_R_interupt(count++);
-        if (count > RCHECK * 1000) fprintf(stderr, "tnorm_tail; count: %i\n", count);
+    alpha = sqrt(chi / psi);
+    omega = sqrt(chi * psi);
+    lam   = fabs(lambda);
+
+    if (lam > 2. || omega > 3.) {
+        // Ratio-of-uniforms with shift by the mode.
+        method = GIG_ROU_SHIFT;
+        t  = 0.5 * (lam - 1.);
+        s  = 0.25 * omega;
+        xm = gig_mode(lam, omega);
+        nc = t * log(xm) - s * (xm + 1. / xm);
+
+        // Location of min and max of (x-xm) sqrt(f(x)), which are the roots
+        // in (0,xm) and (xm,inf) of the cubic y^3 + a y^2 + b y + c.
+        double a = -(2. * (lam + 1.) / omega + xm);
+        double b = (2. * (lam - 1.) * xm / omega - 1.);
+        double c = xm;
+
+        // Depressed cubic z^3 + p z + q with y = z - a/3, Cardano's rule.
+        double p   = b - a*a / 3.;
+        double q   = (2. * a*a*a) / 27. - (a*b) / 3. + c;
+        double fi  = acos(-q / (2. * sqrt(-(p*p*p) / 27.)));
+        double fak = 2. * sqrt(-p / 3.);
+        double y1  = fak * cos(fi / 3.) - a / 3.;
+        double y2  = fak * cos(fi / 3. + 4. / 3. * M_PI) - a / 3.;
+
+        uplus  = (y1 - xm) * exp(t * log(y1) - s * (y1 + 1. / y1) - nc);
+        uminus = (y2 - xm) * exp(t * log(y2) - s * (y2 + 1. / y2) - nc);
     }
-    return (1 + t * E1) / sqrt(t);
-}
-
-//------------------------------------------------------------------------------
-
-// Truncatation at t = 1.
-inline double RNG::right_tgamma_reject(double shape, double rate)
-{
-    double x = 2.0;
-    while (x > 1.0)
-        x = gamma_rate(shape, rate);
-    return x;
-}
-
-double RNG::omega_k(int k, double a, double b)
-{
-    double log_coef = -b + (a+k-1) * log(b) - Gamma(a+k, true) - p_gamma_rate(1.0, a, b, true);
-    return exp(log_coef);
-}
-
-// Truncation at t = 1.
-double RNG::right_tgamma_beta(double shape, double rate)
-{
-    double a = shape;
-    double b = rate;
-
-    double u = unif();
-
-    int k = 1;
-    double cdf = omega_k(1, a, b);
-    while (u > cdf) {
-        cdf += omega_k(++k, a, b);
-        if (k % 100000 == 0) {
-            printf("right_tgamma_beta (itr k=%i): a=%g, b=%g, u=%g, cdf=%g\n", k, a, b, u, cdf);
-#ifdef USE_R
-            R_CheckUserInterrupt();
-#endif
+    else if (lam >= 1. - 2.25 * omega * omega || omega > 0.2) {
+        // Ratio-of-uniforms without shift.
+        method = GIG_ROU_NOSHIFT;
+        t  = 0.5 * (lam - 1.);
+        s  = 0.25 * omega;
+        xm = gig_mode(lam, omega);
+        nc = t * log(xm) - s * (xm + 1. / xm);
+
+        double ym = ((lam + 1.) + sqrt((lam + 1.) * (lam + 1.) + omega * omega)) / omega;
+        um = exp(0.5 * (lam + 1.) * log(ym) - s * (ym + 1. / ym) - nc);
+    }
+    else {
+        // lam < 1 and omega <= 0.2: the density is not T_{-1/2} concave.
+        // Piecewise constant / power / exponential envelope.
+        method = GIG_CONCAVE;
+        xm = gig_mode(lam, omega);
+        x0 = omega / (1. - lam);
+
+        // [0, x0]
+        k0   = exp((lam - 1.) * log(xm) - 0.5 * omega * (xm + 1. / xm));
+        A[0] = k0 * x0;
+
+        if (x0 >= 2. / omega) {
+            k1   = 0.;
+            A[1] = 0.;
+            k2   = pow(x0, lam - 1.);
+            A[2] = k2 * 2. * exp(-omega * x0 / 2.) / omega;
+        }
+        else {
+            // [x0, 2/omega]
+            k1   = exp(-omega);
+            A[1] = (lam == 0.) ? k1 * log(2. / (omega * omega))
+                : k1 / lam * (pow(2. / omega, lam) - pow(x0, lam));
+            // [2/omega, inf]
+            k2   = pow(2. / omega, lam - 1.);
+            A[2] = k2 * 2. * exp(-1.) / omega;
         }
     }
 
-    return beta(a, k);
-}
-
-double RNG::rtgamma_rate(double shape, double rate, double right_t)
-{
-    // x \sim (a,b,t)
-    // ty = x
-    // y \sim (a, bt, 1);
-    double a = shape;
-    double b = rate * right_t;
-
-    double p = p_gamma_rate(1, a, b);
-    double y = 0.0;
-    if (p > 0.95)
-        y = right_tgamma_reject(a, b);
-    else
-        y = right_tgamma_beta(a,b);
-
-    double x = right_t * y;
-    return x;
+    return true;
 }
 
 //------------------------------------------------------------------------------
-double RNG::ltgamma(double shape, double rate, double trunc)
-{
-    double a = shape;
-    double b = rate * trunc;
 
-    if (trunc <=0) {
-        fprintf(stderr, "ltgamma: trunc = %g < 0\n", trunc);
-        return 0;
-    }
-    if (shape < 1) {
-        fprintf(stderr, "ltgamma: shape = %g < 1\n", shape);
-        return 0;
+bool PoisSetup::set(double mu_)
+{
+    mu = mu_;
+    if (!(mu >= 0)) {
+        fprintf(stderr, "PoisSetup::set: mu=%g.\n", mu);
+        mu = -1;
+        return false;
     }
 
-    if (shape ==1) return expon_rate(1) / rate + trunc;
-
-    double d1 = b-a;
-    double d3 = a-1;
-    double c0 = 0.5 * (d1 + sqrt(d1*d1 + 4 * b)) / b;
-
-    double x = 0.0;
-    bool accept = false;
-
-    while (!accept) {
-        x = b + expon_rate(1) / c0;
-        double u = unif();
-
-        double l_rho = d3 * log(x) - x * (1-c0);
-        double l_M   = d3 * log(d3 / (1-c0)) - d3;
-
-        accept = log(u) <= (l_rho - l_M);
+    ptrs = mu >= 10.0;
+    if (!ptrs) {
+        emu = exp(-mu);
+        return true;
     }
 
-    return trunc * (x/b);
+    smu           = sqrt(mu);
+    b             = 0.931 + 2.53 * smu;
+    a             = -0.059 + 0.02483 * b;
+    inv_alpha     = 1.1239 + 1.1328 / (b - 3.4);
+    vr            = 0.9277 - 3.6224 / (b - 2);
+    log_mu        = log(mu);
+    log_inv_alpha = log(inv_alpha);
+    return true;
 }
 
-//------------------------------------------------------------------------------
-double RNG::igauss(double mu, double lambda)
+bool BinomSetup::set(int n_, double p_)
 {
-    // See R code for specifics.
-    double mu2 = mu * mu;
-    double Y = norm(0.0, 1.0);
-    Y *= Y;
-    double W = mu + 0.5 * mu2 * Y / lambda;
-    double X = W - sqrt(W*W - mu2);
-    if (unif() > mu / (mu + X))
-        X = mu2 / X;
-    return X;
-}
+    n = n_;
+    p = p_;
+    if (n < 0 || !(p >= 0 && p <= 1)) {
+        fprintf(stderr, "BinomSetup::set: n=%i, p=%g.\n", n, p);
+        n = -1;
+        return false;
+    }
 
-//------------------------------------------------------------------------------
-double RNG::rtinvchi2(double scale, double trunc)
-{
-    double R = trunc / scale;
-    // double X = 0.0;
-    // // I need to consider using a different truncated normal sampler.
-    // double E1 = r.expon_rate(1.0); double E2 = r.expon_rate(1.0);
-    // while ( (E1*E1) > (2 * E2 / R)) {
-    //   // printf("E %g %g %g %g\n", E1, E2, E1*E1, 2*E2/R);
-    //   E1 = r.expon_rate(1.0); E2 = r.expon_rate(1.0);
-    // }
-    // // printf("E %g %g \n", E1, E2);
-    // X = 1 + E1 * R;
-    // X = R / (X * X);
-    // X = scale * X;
-    double E = tnorm(1/sqrt(R));
-    double X = scale / (E*E);
-    return X;
-}
+    flip = p > 0.5;
+    double pp = flip ? 1.0 - p : p;
+    double q  = 1.0 - pp;
 
-//------------------------------------------------------------------------------
+    btrs = n * pp >= 10.0;
+    if (!btrs) {
+        q_n = pow(q, n);
+        r   = pp / q;
+        return true;
+    }
 
-double RNG::Beta(double a, double b, bool log)
-{
-    double out = Gamma(a, true) + Gamma(b, true) - Gamma(a+b,true);
-    if (!log) out = exp(out);
-    return out;
+    spq   = sqrt(n * pp * q);
+    b     = 1.15 + 2.53 * spq;
+    a     = -0.0873 + 0.0248 * b + 0.01 * pp;
+    c     = n * pp + 0.5;
+    vr    = 0.92 - 4.2 / b;
+    alpha = (2.83 + 5.1 / b) * spq;
+    lpq   = log(pp / q);
+    m     = floor((n + 1) * pp);
+    h     = RNGMath::lgamma(m + 1) + RNGMath::lgamma(n - m + 1);
+    return true;
 }
 
-//------------------------------------------------------------------------------
+//////////////////////////////////////////////////////////////////////
+			  // INSTANTIATE //
+//////////////////////////////////////////////////////////////////////
 
-double RNG::p_igauss(double x, double mu, double lambda)
-{
-    // z = 1 / mean
-    double z = 1 / mu;
-    double b = sqrt(lambda / x) * (x * z - 1);
-    double a = sqrt(lambda / x) * (x * z + 1) * -1.0;
-    double y = RNG::p_norm(b) + exp(2 * lambda * z) * RNG::p_norm(a);
-    return y;
-}
+template class RNGT<BasicRNG>;
@@ -0,0 +1,223 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Lazy sampling expressions, evaluated in one pass.
+
+  Filling an array with r.norm(M, 0, 1) and then scaling, shifting, or
+  summing it walks the whole array once per step.  An expression
+  instead describes the variates and what to do with them,
+
+    fill(M, 2.0 * norm_expr(r) + 1.0);          // One write per entry.
+    double s = sum(square(norm_expr(r)), n);    // No array at all.
+
+  and the terminal -- fill, sum, or reduce -- evaluates it RNG_BLOCK
+  entries at a time.  The sources draw a block with RNG's own array
+  samplers into a buffer on the stack, or straight into the output
+  when it is contiguous, and every node then works on that block in
+  place while it is still in cache.
+
+  Sources: unif_expr, flat_expr, norm_expr, expon_expr, gamma_expr,
+  chisq_expr, each taking the RNG first, which must outlive the
+  expression.  Nodes: a * e + b with doubles a and b, e1 + e2, e1 - e2,
+  e1 * e2, e1 / e2, square(e), and apply(e, f) for any f(double), a
+  function pointer or a functor.  The variates are drawn in the order
+  the sources appear, block by block, so an expression with one source
+  gives exactly the draws of the array sampler.
+
+  Each appearance of a source draws its own block, even when it is the
+  same object.  With z = norm_expr(r), z * z is the product of two
+  independent normals, not a square; use square(z) for that.
+
+*********************************************************************/
+
+#ifndef __RNGEXPR__
+#define __RNGEXPR__
+
+#include "RNG.hpp"
+
+// Every node derives from RNGExpr<Node> and has
+//
+//   void eval(double* x, size_t m) const;   // m <= RNG_BLOCK
+//
+// which writes the next m values of the expression to x.
+
+template<typename D> struct RNGExpr {
+  const D& self() const { return *static_cast<const D*>(this); }
+};
+
+//////////////////////////////////////////////////////////////////////
+			     // Sources //
+//////////////////////////////////////////////////////////////////////
+
+#define EXPR_SOURCE(NAME, CALL)						\
+  template<typename R> struct NAME : public RNGExpr< NAME<R> > {	\
+    R* r; double p1, p2;						\
+    NAME(R& r_, double p1_, double p2_) : r(&r_), p1(p1_), p2(p2_) {} \
+    void eval(double* x, size_t m) const				\
+    {									\
+      RNGSpan S(x, m);							\
+      r->CALL;								\
+    }									\
+  };									\
+
+EXPR_SOURCE(UnifExpr , unif(S))
+EXPR_SOURCE(FlatExpr , flat(S, p1, p2))
+EXPR_SOURCE(NormExpr , norm(S, p1, p2))
+EXPR_SOURCE(ExponExpr, expon_rate(S, p1))
+EXPR_SOURCE(GammaExpr, gamma_rate(S, p1, p2))
+EXPR_SOURCE(ChisqExpr, chisq(S, p1))
+
+#undef EXPR_SOURCE
+
+template<typename R> UnifExpr<R>  unif_expr (R& r) { return UnifExpr<R>(r, 0, 0); }
+template<typename R> FlatExpr<R>  flat_expr (R& r, double a=0, double b=1) { return FlatExpr<R>(r, a, b); }
+template<typename R> NormExpr<R>  norm_expr (R& r, double mean=0, double sd=1) { return NormExpr<R>(r, mean, sd); }
+template<typename R> ExponExpr<R> expon_expr(R& r, double rate=1) { return ExponExpr<R>(r, rate, 0); }
+template<typename R> GammaExpr<R> gamma_expr(R& r, double shape, double rate) { return GammaExpr<R>(r, shape, rate); }
+template<typename R> ChisqExpr<R> chisq_expr(R& r, double df) { return ChisqExpr<R>(r, df, 0); }
+
+//////////////////////////////////////////////////////////////////////
+			      // Nodes //
+//////////////////////////////////////////////////////////////////////
+
+// a * e + b
+template<typename E> struct AffineExpr : public RNGExpr< AffineExpr<E> > {
+  E e; double a, b;
+  AffineExpr(const E& e_, double a_, double b_) : e(e_), a(a_), b(b_) {}
+  void eval(double* x, size_t m) const
+  {
+    e.eval(x, m);
+    for (size_t i = 0; i < m; i++) x[i] = a * x[i] + b;
+  }
+};
+
+template<typename E, typename F> struct ApplyExpr : public RNGExpr< ApplyExpr<E, F> > {
+  E e; F f;
+  ApplyExpr(const E& e_, const F& f_) : e(e_), f(f_) {}
+  void eval(double* x, size_t m) const
+  {
+    e.eval(x, m);
+    for (size_t i = 0; i < m; i++) x[i] = f(x[i]);
+  }
+};
+
+struct ExprSquare { double operator()(double v) const { return v * v; } };
+
+struct ExprPlus   { double operator()(double u, double v) const { return u + v; } };
+struct ExprMinus  { double operator()(double u, double v) const { return u - v; } };
+struct ExprTimes  { double operator()(double u, double v) const { return u * v; } };
+struct ExprDivide { double operator()(double u, double v) const { return u / v; } };
+
+template<typename E1, typename E2, typename Op> struct BinaryExpr : public RNGExpr< BinaryExpr<E1, E2, Op> > {
+  E1 e1; E2 e2;
+  BinaryExpr(const E1& e1_, const E2& e2_) : e1(e1_), e2(e2_) {}
+  void eval(double* x, size_t m) const
+  {
+    double y[RNG_BLOCK];
+    Op op;
+    e1.eval(x, m);
+    e2.eval(y, m);
+    for (size_t i = 0; i < m; i++) x[i] = op(x[i], y[i]);
+  }
+};
+
+template<typename E> AffineExpr<E> operator*(double a, const RNGExpr<E>& e) { return AffineExpr<E>(e.self(), a, 0); }
+template<typename E> AffineExpr<E> operator*(const RNGExpr<E>& e, double a) { return AffineExpr<E>(e.self(), a, 0); }
+template<typename E> AffineExpr<E> operator/(const RNGExpr<E>& e, double a) { return AffineExpr<E>(e.self(), 1.0 / a, 0); }
+template<typename E> AffineExpr<E> operator+(const RNGExpr<E>& e, double b) { return AffineExpr<E>(e.self(), 1, b); }
+template<typename E> AffineExpr<E> operator+(double b, const RNGExpr<E>& e) { return AffineExpr<E>(e.self(), 1, b); }
+template<typename E> AffineExpr<E> operator-(const RNGExpr<E>& e, double b) { return AffineExpr<E>(e.self(), 1, -b); }
+template<typename E> AffineExpr<E> operator-(double b, const RNGExpr<E>& e) { return AffineExpr<E>(e.self(), -1, b); }
+template<typename E> AffineExpr<E> operator-(const RNGExpr<E>& e) { return AffineExpr<E>(e.self(), -1, 0); }
+
+// Fold a * (c * e + d) + b into one node.
+template<typename E> AffineExpr<E> operator*(double a, const AffineExpr<E>& e) { return AffineExpr<E>(e.e, a * e.a, a * e.b); }
+template<typename E> AffineExpr<E> operator*(const AffineExpr<E>& e, double a) { return AffineExpr<E>(e.e, a * e.a, a * e.b); }
+template<typename E> AffineExpr<E> operator+(const AffineExpr<E>& e, double b) { return AffineExpr<E>(e.e, e.a, e.b + b); }
+template<typename E> AffineExpr<E> operator+(double b, const AffineExpr<E>& e) { return AffineExpr<E>(e.e, e.a, e.b + b); }
+template<typename E> AffineExpr<E> operator-(const AffineExpr<E>& e, double b) { return AffineExpr<E>(e.e, e.a, e.b - b); }
+
+#define EXPR_BINARY(OP, NAME)						\
+  template<typename E1, typename E2>					\
+  BinaryExpr<E1, E2, NAME> operator OP(const RNGExpr<E1>& e1, const RNGExpr<E2>& e2) \
+  { return BinaryExpr<E1, E2, NAME>(e1.self(), e2.self()); }		\
+
+EXPR_BINARY(+, ExprPlus)
+EXPR_BINARY(-, ExprMinus)
+EXPR_BINARY(*, ExprTimes)
+EXPR_BINARY(/, ExprDivide)
+
+#undef EXPR_BINARY
+
+template<typename E> ApplyExpr<E, ExprSquare> square(const RNGExpr<E>& e)
+{ return ApplyExpr<E, ExprSquare>(e.self(), ExprSquare()); }
+
+template<typename E, typename F> ApplyExpr<E, F> apply(const RNGExpr<E>& e, F f)
+{ return ApplyExpr<E, F>(e.self(), f); }
+
+//////////////////////////////////////////////////////////////////////
+			    // Terminals //
+//////////////////////////////////////////////////////////////////////
+
+// M = e, one entry at a time.
+template<typename Mat, typename E> void fill(Mat& M, const RNGExpr<E>& e)
+{
+  size_t  n = M.size();
+  double* x = mat_ptr(M);
+  double  Y[RNG_BLOCK];
+  for (size_t start = 0; start < n; start += RNG_BLOCK) {
+    size_t len = n - start < RNG_BLOCK ? n - start : RNG_BLOCK;
+    if (x)
+      e.self().eval(x + start, len);
+    else {
+      e.self().eval(Y, len);
+      mat_store(M, x, start, Y, len);
+    }
+  }
+}
+
+// op(... op(op(init, e_0), e_1) ..., e_{n-1}), nothing stored.
+template<typename E, typename Op> double reduce(const RNGExpr<E>& e, size_t n, double init, Op op)
+{
+  double Y[RNG_BLOCK];
+  double acc = init;
+  for (size_t start = 0; start < n; start += RNG_BLOCK) {
+    size_t len = n - start < RNG_BLOCK ? n - start : RNG_BLOCK;
+    e.self().eval(Y, len);
+    for (size_t i = 0; i < len; i++) acc = op(acc, Y[i]);
+  }
+  return acc;
+}
+
+// Sum of n entries, by blocks so that rounding does not pile up.
+template<typename E> double sum(const RNGExpr<E>& e, size_t n)
+{
+  double Y[RNG_BLOCK];
+  double acc = 0.0;
+  for (size_t start = 0; start < n; start += RNG_BLOCK) {
+    size_t len = n - start < RNG_BLOCK ? n - start : RNG_BLOCK;
+    e.self().eval(Y, len);
+    double s = 0.0;
+    for (size_t i = 0; i < len; i++) s += Y[i];
+    acc += s;
+  }
+  return acc;
+}
+
+#endif
@@ -0,0 +1,1342 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  The definitions of RNGT's samplers.
+
+  RNG.cpp includes this file and instantiates RNGT<BasicRNG>, i.e.
+  RNG.  To use RNGT with another engine, include this file in one of
+  your translation units and add
+
+    template class RNGT<MyEngine>;
+
+  Only include it once per engine.  Everywhere else RNG.hpp is enough.
+
+*********************************************************************/
+
+#ifndef __RNGIMPL__
+#define __RNGIMPL__
+
+#include "RNG.hpp"
+
+// Throw runtime exception or return.
+#ifndef TREOR
+#ifndef NTHROW
+#define TREOR(MESS, VAL) throw std::runtime_error(MESS);
+#else
+#define TREOR(MESS, VAL) {fprintf(stderr, MESS); return VAL;}
+#endif
+#endif
+
+#ifndef RCHECK
+#define RCHECK 1000
+#endif
+
+inline void check_R_interupt(int count)
+{
+    #ifdef USE_R
+    if (count % RCHECK == 0) R_CheckUserInterrupt();
+    #endif
+}
+
+// Truncated Exponential
+template<typename Engine>
+double RNGT<Engine>::texpon_rate(double left, double rate){
+    if (rate < 0) TREOR("texpon_rate: rate < 0, return 0\n", 0.0);
+    // return left - log(unif()) / rate;
+    return expon_rate(rate) + left;
+}
+
+template<typename Engine>
+double RNGT<Engine>::texpon_rate(double left, double right, double rate)
+{
+    if (left == right) return left;
+    if (left > right) TREOR("texpon_rate: left > right, return 0.\n", 0.0);
+    if (rate < 0) TREOR("texpon_rate: rate < 0, return 0\n", 0.0);
+
+    double b = 1 - exp(rate * (left - right));
+    double y = 1 - b * unif();
+    return left - log(y) / rate;
+}
+
+//////////////////////////////////////////////////////////////////////
+	       // TRUNCATED NORMAL HELPER FUNCTIONS //
+//////////////////////////////////////////////////////////////////////
+
+template<typename Engine>
+double RNGT<Engine>::alphastar(double left)
+{
+    return 0.5 * (left + sqrt(left*left + 4));
+} // alphastar
+
+template<typename Engine>
+double RNGT<Engine>::lowerbound(double left)
+{
+    double astar  = alphastar(left);
+    double lbound = left + exp(0.5 * + 0.5 * left * (left - astar)) / astar;
+    return lbound;
+} // lowerbound
+
+//////////////////////////////////////////////////////////////////////
+		     // DRAW TRUNCATED NORMAL //
+//////////////////////////////////////////////////////////////////////
+
+// The kernels.  Each is valid for any left < right, where right may be
+// infinite for tnorm_norm and tnorm_expon; tnorm picks the cheapest, see
+// RNGSelect.hpp.
+
+// Accept/Reject Normal.
+template<typename Engine>
+double RNGT<Engine>::tnorm_norm(double left, double right)
+{
+    double ppsl;
+    int count = 1;
+    while (true) {
+        ppsl = norm(0.0, 1.0);
+        if (left < ppsl && ppsl < right) return ppsl;
+        check_R_interupt(count++);
+        #ifndef NDEBUG
+        if (count > RCHECK * 1000) fprintf(stderr, "tnorm_norm; count: %i\n", count);
+        #endif
+    }
+} // tnorm_norm
+
+// Accept/Reject Exponential, Robert (1995).
+template<typename Engine>
+double RNGT<Engine>::tnorm_expon(double left, double right)
+{
+    // return tnorm_tail(left); // Use Devroye.
+    double rho, ppsl;
+    int count = 1;
+    double astar = alphastar(left);
+    while (true) {
+        ppsl = right == HUGE_VAL ? texpon_rate(left, astar) : texpon_rate(left, right, astar);
+        rho  = exp(-0.5 * (ppsl - astar) * (ppsl - astar));
+        if (unif() < rho) return ppsl;
+        check_R_interupt(count++);
+        #ifndef NDEBUG
+        if (count > RCHECK * 1000) fprintf(stderr, "tnorm_expon; count: %i\n", count);
+        #endif
+    }
+} // tnorm_expon
+
+// Accept/Reject Uniform, against the density at m, the mode in [left, right].
+template<typename Engine>
+double RNGT<Engine>::tnorm_flat(double left, double right)
+{
+    double rho, ppsl;
+    int count = 1;
+    double m = left > 0 ? left : (right < 0 ? right : 0.0);
+    while (true) {
+        ppsl = flat(left, right);
+        rho  = exp(0.5 * (m*m - ppsl*ppsl));
+        if (unif() < rho) return ppsl;
+        check_R_interupt(count++);
+        #ifndef NDEBUG
+        if (count > RCHECK * 1000) fprintf(stderr, "tnorm_flat; count: %i\n", count);
+        #endif
+    }
+} // tnorm_flat
+
+//--------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::tnorm(double left)
+{
+    if (select_tnorm(left) == TN_NORM)
+        return tnorm_norm(left, HUGE_VAL);
+    else
+        return tnorm_expon(left, HUGE_VAL);
+} // tnorm
+//--------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::tnorm(double left, double right)
+{
+    // Check input
+    #ifdef USE_R
+    if (ISNAN(right) || ISNAN(left))
+    #else
+    if (std::isnan(right) || std::isnan(left))
+    #endif
+	{
+	    fprintf(stderr, "Warning: nan sent to RNG::tnorm: left=%g, right=%g\n", left, right);
+	    TREOR("RNG::tnorm: parameter problem.\n", 0.5 * (left + right));
+	    // throw std::runtime_error("RNG::tnorm: parameter problem.\n");
+	}
+    
+    if (right < left) {
+        fprintf(stderr, "Warning: left: %g, right:%g.\n", left, right);
+        TREOR("RNG::tnorm: parameter problem.\n", 0.5 * (left + right));
+    }
+
+    if (right < 0)
+        return -1. * tnorm(-1.0 * right, -1.0 * left);
+
+    switch (select_tnorm(left, right)) {
+    case TN_NORM:
+        return tnorm_norm(left, right);
+    case TN_EXPON:
+        return tnorm_expon(left, right);
+    default:
+        return tnorm_flat(left, right);
+    }
+} // tnorm
+//--------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::tnorm(double left, double mu, double sd)
+{
+    double newleft = (left - mu) / sd;
+    return mu + tnorm(newleft) * sd;
+} // tnorm
+//--------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::tnorm(double left, double right, double mu, double sd)
+{
+    if (left==right) return left;
+
+    double newleft  = (left - mu) / sd;
+    double newright = (right - mu) / sd;
+
+    // I want to check this here as well so we can see what the input was.
+    // It may be more elegant to try and catch tdraw.
+    if (newright < newleft) {
+        fprintf(stderr, "left, right, mu, sd: %g, %g, %g, %g \n", left, right, mu, sd);
+        fprintf(stderr, "nleft, nright: %g, %g\n", newleft, newright);
+        TREOR("RNG::tnorm: parameter problem.\n", 0.5 * (left + right));
+    }
+
+    double tdraw = tnorm(newleft, newright);
+    double draw = mu + tdraw * sd;
+
+    // It may be the case that there is some numerical error and that the draw
+    // ends up out of bounds.
+    if (draw < left || draw > right){
+        fprintf(stderr, "Error in tnorm: draw not in bounds.\n");
+        fprintf(stderr, "left, right, mu, sd: %g, %g, %g, %g\n", left, right, mu, sd);
+        fprintf(stderr, "nleft, nright, tdraw, draw: %g, %g, %g, %g\n", newleft, newright, tdraw, draw);
+        TREOR("Aborting and returning average of left and right.\n",  0.5 * (left + right));
+    }
+
+    return draw;
+} // tnorm
+//--------------------------------------------------------------------
+
+// Right tail of normal by Devroye
+//------------------------------------------------------------------------------
+template<typename Engine>
+double RNGT<Engine>::tnorm_tail(double t)
+{
+    int count = 1;
+
+    double E1 = expon_rate(1.0);
+    double E2 = expon_rate(1.0);
+    while ( E1*E1 > 2 * E2 / t) {
+        E1 = expon_rate(1.0);
+        E2 = expon_rate(1.0);
+        check_R_interupt(count++);
+        if (count > RCHECK * 1000) fprintf(stderr, "tnorm_tail; count: %i\n", count);
+    }
+    return (1 + t * E1) / sqrt(t);
+}
+
+//------------------------------------------------------------------------------
+
+// Truncatation at t = 1.
+template<typename Engine>
+double RNGT<Engine>::right_tgamma_reject(double shape, double rate)
+{
+    double x = 2.0;
+    while (x > 1.0)
+        x = gamma_rate(shape, rate);
+    return x;
+}
+
+// lgamma(a+k) comes from the offset table for base a and the gamma CDF is
+// memoized, so the k-th term costs a log and an exp.
+template<typename Engine>
+double RNGT<Engine>::omega_k(int k, double a, double b)
+{
+    double log_coef = -b + (a+k-1) * log(b) - gcache.lgamma(a, k) - gcache.p_gamma_rate(1.0, a, b, true);
+    return exp(log_coef);
+}
+
+// Truncation at t = 1.
+template<typename Engine>
+double RNGT<Engine>::right_tgamma_beta(double shape, double rate)
+{
+    double a = shape;
+    double b = rate;
+
+    double u = unif();
+
+    int k = 1;
+    double cdf = omega_k(1, a, b);
+    while (u > cdf) {
+        cdf += omega_k(++k, a, b);
+        if (k % 100000 == 0) {
+            printf("right_tgamma_beta (itr k=%i): a=%g, b=%g, u=%g, cdf=%g\n", k, a, b, u, cdf);
+#ifdef USE_R
+            R_CheckUserInterrupt();
+#endif
+        }
+    }
+
+    return beta(a, k);
+}
+
+template<typename Engine>
+double RNGT<Engine>::rtgamma_rate(double shape, double rate, double right_t)
+{
+    // x \sim (a,b,t)
+    // ty = x
+    // y \sim (a, bt, 1);
+    double a = shape;
+    double b = rate * right_t;
+
+    // The table decides without the gamma CDF, except out of its range.
+    // The CDF is memoized, since right_tgamma_beta needs it too.
+    int alg = select_rtgamma(a, b);
+    if (alg < 0)
+        alg = gcache.p_gamma_rate(1.0, a, b) > RTG_REJECT_P ? RTG_REJECT : RTG_BETA;
+
+    double y = 0.0;
+    if (alg == RTG_REJECT)
+        y = right_tgamma_reject(a, b);
+    else
+        y = right_tgamma_beta(a,b);
+
+    double x = right_t * y;
+    return x;
+}
+
+//------------------------------------------------------------------------------
+template<typename Engine>
+double RNGT<Engine>::ltgamma(double shape, double rate, double trunc)
+{
+    double a = shape;
+    double b = rate * trunc;
+
+    if (trunc <=0) {
+        fprintf(stderr, "ltgamma: trunc = %g < 0\n", trunc);
+        return 0;
+    }
+    if (shape < 1) {
+        fprintf(stderr, "ltgamma: shape = %g < 1\n", shape);
+        return 0;
+    }
+
+    if (shape ==1) return expon_rate(1) / rate + trunc;
+
+    double d1 = b-a;
+    double d3 = a-1;
+    double c0 = 0.5 * (d1 + sqrt(d1*d1 + 4 * b)) / b;
+
+    double x = 0.0;
+    bool accept = false;
+
+    while (!accept) {
+        x = b + expon_rate(1) / c0;
+        double u = unif();
+
+        double l_rho = d3 * log(x) - x * (1-c0);
+        double l_M   = d3 * log(d3 / (1-c0)) - d3;
+
+        accept = log(u) <= (l_rho - l_M);
+    }
+
+    return trunc * (x/b);
+}
+
+//------------------------------------------------------------------------------
+template<typename Engine>
+double RNGT<Engine>::igauss(double mu, double lambda)
+{
+    // See R code for specifics.
+    double mu2 = mu * mu;
+    double Y = norm(0.0, 1.0);
+    Y *= Y;
+    double W = mu + 0.5 * mu2 * Y / lambda;
+    double X = W - sqrt(W*W - mu2);
+    if (unif() > mu / (mu + X))
+        X = mu2 / X;
+    return X;
+}
+
+//------------------------------------------------------------------------------
+	       // GENERALIZED INVERSE GAUSSIAN //
+//------------------------------------------------------------------------------
+
+// See Hormann and Leydold (2014), Generating generalized inverse Gaussian
+// random variates, Statistics and Computing, and the R package GIGrvg.
+
+template<typename Engine>
+double RNGT<Engine>::gig(const GIGSetup& gs)
+{
+    double X = 0.0, U, V;
+    int count = 1;
+
+    switch (gs.method) {
+
+    case GIG_GAMMA:
+        return gamma_rate(gs.lambda, 0.5 * gs.psi);
+
+    case GIG_IGAMMA:
+        return igamma(-1.0 * gs.lambda, 0.5 * gs.chi);
+
+    case GIG_ROU_NOSHIFT:
+        while (true) {
+            U = gs.um * unif();
+            V = unif();
+            X = U / V;
+            if (log(V) <= gs.t * log(X) - gs.s * (X + 1. / X) - gs.nc) break;
+            check_R_interupt(count++);
+        }
+        break;
+
+    case GIG_ROU_SHIFT:
+        while (true) {
+            U = gs.uminus + unif() * (gs.uplus - gs.uminus);
+            V = unif();
+            X = U / V + gs.xm;
+            if (X > 0. && log(V) <= gs.t * log(X) - gs.s * (X + 1. / X) - gs.nc) break;
+            check_R_interupt(count++);
+        }
+        break;
+
+    case GIG_CONCAVE:
+        while (true) {
+            double hx;
+            V = (gs.A[0] + gs.A[1] + gs.A[2]) * unif();
+            if (V <= gs.A[0]) {
+                X  = gs.x0 * V / gs.A[0];
+                hx = gs.k0;
+            }
+            else if (V - gs.A[0] <= gs.A[1]) {
+                V -= gs.A[0];
+                if (gs.lam == 0.) {
+                    X  = gs.omega * exp(exp(gs.omega) * V);
+                    hx = gs.k1 / X;
+                }
+                else {
+                    X  = pow(pow(gs.x0, gs.lam) + (gs.lam / gs.k1 * V), 1. / gs.lam);
+                    hx = gs.k1 * pow(X, gs.lam - 1.);
+                }
+            }
+            else {
+                V -= gs.A[0] + gs.A[1];
+                double a = (gs.x0 > 2. / gs.omega) ? gs.x0 : 2. / gs.omega;
+                X  = -2. / gs.omega * log(exp(-0.5 * gs.omega * a) - 0.5 * gs.omega / gs.k2 * V);
+                hx = gs.k2 * exp(-0.5 * gs.omega * X);
+            }
+            U = unif() * hx;
+            if (log(U) <= (gs.lam - 1.) * log(X) - 0.5 * gs.omega * (X + 1. / X)) break;
+            check_R_interupt(count++);
+        }
+        break;
+
+    default:
+        TREOR("RNG::gig: GIGSetup not set.\n", 0.0);
+
+    }
+
+    return gs.lambda < 0 ? gs.alpha / X : gs.alpha * X;
+}
+
+template<typename Engine>
+double RNGT<Engine>::gig(double lambda, double chi, double psi)
+{
+    GIGSetup gs(lambda, chi, psi);
+    return gig(gs);
+}
+
+//------------------------------------------------------------------------------
+template<typename Engine>
+double RNGT<Engine>::rtigauss(double mu, double lambda, double trunc)
+{
+    // IG(mu, lambda) truncated to (0, trunc).  When trunc < mu propose from
+    // the mu = infinity case, lambda / chi^2_1, and accept with the tilt.
+    double X = trunc + 1.0;
+    int count = 1;
+    if (trunc < mu) {
+        double alpha = 0.0;
+        while (unif() > alpha) {
+            X = rtinvchi2(lambda, trunc);
+            alpha = exp(-0.5 * lambda / (mu*mu) * X);
+            check_R_interupt(count++);
+        }
+    }
+    else {
+        while (X > trunc) {
+            X = igauss(mu, lambda);
+            check_R_interupt(count++);
+        }
+    }
+    return X;
+}
+
+//------------------------------------------------------------------------------
+template<typename Engine>
+double RNGT<Engine>::rtinvchi2(double scale, double trunc)
+{
+    double R = trunc / scale;
+    // double X = 0.0;
+    // // I need to consider using a different truncated normal sampler.
+    // double E1 = r.expon_rate(1.0); double E2 = r.expon_rate(1.0);
+    // while ( (E1*E1) > (2 * E2 / R)) {
+    //   // printf("E %g %g %g %g\n", E1, E2, E1*E1, 2*E2/R);
+    //   E1 = r.expon_rate(1.0); E2 = r.expon_rate(1.0);
+    // }
+    // // printf("E %g %g \n", E1, E2);
+    // X = 1 + E1 * R;
+    // X = R / (X * X);
+    // X = scale * X;
+    double E = tnorm(1/sqrt(R));
+    double X = scale / (E*E);
+    return X;
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::Beta(double a, double b, bool log)
+{
+    double out = Gamma(a, true) + Gamma(b, true) - Gamma(a+b,true);
+    if (!log) out = exp(out);
+    return out;
+}
+
+template<typename Engine>
+double RNGT<Engine>::Beta(double a, double b, bool log, GammaCache& cache)
+{
+    double out = cache.lgamma(a) + cache.lgamma(b) - cache.lgamma(a+b);
+    if (!log) out = exp(out);
+    return out;
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::p_igauss(double x, double mu, double lambda)
+{
+    // z = 1 / mean
+    double z = 1 / mu;
+    double b = sqrt(lambda / x) * (x * z - 1);
+    double a = sqrt(lambda / x) * (x * z + 1) * -1.0;
+    // exp(2 lambda z) P(Z < a) in logs, since it overflows for large lambda z.
+    double y = Engine::p_norm(b) + exp(2 * lambda * z + RNGMath::log_p_norm(a));
+    return y;
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // DENSITIES //
+//////////////////////////////////////////////////////////////////////
+
+// Each works out the log density and exponentiates it unless use_log.
+// The array versions in RNG.hpp follow the same formulas.
+
+#define RNG_DENS(ld) return use_log ? (ld) : exp(ld)
+
+template<typename Engine>
+double RNGT<Engine>::d_flat(double x, double a, double b, int use_log)
+{
+    double ld = (x < a || x > b) ? -HUGE_VAL : -log(b - a);
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_expon_rate(double x, double rate, int use_log)
+{
+    double ld = x < 0 ? -HUGE_VAL : log(rate) - rate * x;
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_expon_mean(double x, double mean, int use_log)
+{
+    return d_expon_rate(x, 1.0 / mean, use_log);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_norm(double x, double mean, double sd, int use_log)
+{
+    double z  = (x - mean) / sd;
+    double ld = -0.5 * z * z - log(sd) - RNG_LOG_SQRT_2PI;
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_gamma_rate(double x, double shape, double rate, int use_log)
+{
+    double ld = x < 0 ? -HUGE_VAL
+	: shape * log(rate) - RNGMath::lgamma(shape) + RNGMath::xlogy(shape - 1, x) - rate * x;
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_gamma_scale(double x, double shape, double scale, int use_log)
+{
+    return d_gamma_rate(x, shape, 1.0 / scale, use_log);
+}
+
+// igamma(shape, scale) is 1 / gamma_rate(shape, scale).
+
+template<typename Engine>
+double RNGT<Engine>::d_igamma(double x, double shape, double scale, int use_log)
+{
+    double ld = x <= 0 ? -HUGE_VAL
+	: shape * log(scale) - RNGMath::lgamma(shape) - (shape + 1) * log(x) - scale / x;
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_chisq(double x, double df, int use_log)
+{
+    return d_gamma_rate(x, 0.5 * df, 0.5, use_log);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_beta(double x, double a, double b, int use_log)
+{
+    double lB = RNGMath::lgamma(a) + RNGMath::lgamma(b) - RNGMath::lgamma(a+b);
+    double ld = (x < 0 || x > 1) ? -HUGE_VAL
+	: RNGMath::xlogy(a - 1, x) + (b == 1 ? 0.0 : (b - 1) * log1p(-x)) - lB;
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_tnorm(double x, double left, double right, double mu, double sd, int use_log)
+{
+    double lZ = RNGMath::log_p_norm_range((left - mu) / sd, (right - mu) / sd);
+    double ld = (x < left || x > right) ? -HUGE_VAL : d_norm(x, mu, sd, 1) - lZ;
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_igauss(double x, double mu, double lambda, int use_log)
+{
+    double d  = x - mu;
+    double ld = x <= 0 ? -HUGE_VAL
+	: 0.5 * log(lambda) - RNG_LOG_SQRT_2PI - 1.5 * log(x) - lambda * d * d / (2 * mu * mu * x);
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_poisson(double k, double mu, int use_log)
+{
+    double ld = (k < 0 || k != floor(k)) ? -HUGE_VAL
+	: RNGMath::xlogy(k, mu) - mu - RNGMath::lgamma(k + 1);
+    RNG_DENS(ld);
+}
+
+template<typename Engine>
+double RNGT<Engine>::d_binom(double k, double n, double p, int use_log)
+{
+    double ld = (k < 0 || k > n || k != floor(k)) ? -HUGE_VAL
+	: RNGMath::lgamma(n + 1) - RNGMath::lgamma(k + 1) - RNGMath::lgamma(n - k + 1)
+	+ RNGMath::xlogy(k, p) + RNGMath::xlogy(n - k, 1 - p);
+    RNG_DENS(ld);
+}
+
+// negbin(size, p) counts failures before the size-th success, as in R.
+
+template<typename Engine>
+double RNGT<Engine>::d_negbin(double k, double size, double p, int use_log)
+{
+    double ld = (k < 0 || k != floor(k)) ? -HUGE_VAL
+	: RNGMath::lgamma(k + size) - RNGMath::lgamma(size) - RNGMath::lgamma(k + 1)
+	+ size * log(p) + RNGMath::xlogy(k, 1 - p);
+    RNG_DENS(ld);
+}
+
+#undef RNG_DENS
+
+//////////////////////////////////////////////////////////////////////
+			    // POLYA-GAMMA //
+//////////////////////////////////////////////////////////////////////
+
+// PG(b, z) as in Polson, Scott, and Windle (2013) and Windle, Polson, and
+// Scott (2014).  J^*(b, z) = 4 PG(b, 2z).  We choose the method by b:
+//
+//   b > 170      : normal approximation with the exact mean and variance.
+//   b >= 13      : saddle point approximation.
+//   otherwise    : Devroye's method for each of the floor(b) PG(1, z)
+//                  terms and a truncated sum of gammas for the remainder.
+
+#define PG_TRUNC     0.64
+#define PG_SP_MIN    13.0
+#define PG_NORM_MIN  170.0
+#define PG_SUM_TERMS 50
+
+// log(cosh(z)) without overflow.
+inline double log_cosh(double z)
+{
+    z = fabs(z);
+    return z + log1p(exp(-2.0 * z)) - M_LN2;
+}
+
+//------------------------------------------------------------------------------
+		       // Devroye, b = 1 //
+
+// Coefficients of the alternating series for the density of J^*(1, 0).
+inline double pg_a(int n, double x)
+{
+    double K = (n + 0.5) * M_PI;
+    if (x > PG_TRUNC)
+        return K * exp(-0.5 * K*K * x);
+    else if (x > 0) {
+        double expnt = -1.5 * (log(0.5 * M_PI) + log(x)) + log(K) - 2.0 * (n+0.5)*(n+0.5) / x;
+        return exp(expnt);
+    }
+    return 0.0;
+}
+
+// Probability of proposing from the truncated exponential piece.
+inline double pg_mass_texpon(double Z)
+{
+    double t  = PG_TRUNC;
+    double fz = 0.125 * M_PI*M_PI + 0.5 * Z*Z;
+    double b  = sqrt(1.0 / t) * (t * Z - 1);
+    double a  = sqrt(1.0 / t) * (t * Z + 1) * -1.0;
+    double x0 = log(fz) + fz * t;
+    double xb = x0 - Z + RNGMath::log_p_norm(b);
+    double xa = x0 + Z + RNGMath::log_p_norm(a);
+    double qdivp = 4 / M_PI * ( exp(xb) + exp(xa) );
+    return 1.0 / (1.0 + qdivp);
+}
+
+template<typename Engine>
+double RNGT<Engine>::pg_devroye(double z)
+{
+    // Sample J^*(1, Z) with Z = |z|/2 and return PG(1, z) = J^*(1, Z) / 4.
+    double Z     = 0.5 * fabs(z);
+    double fz    = 0.125 * M_PI*M_PI + 0.5 * Z*Z;
+    double mu    = Z > 0 ? 1.0 / Z : HUGE_VAL;
+    double ptexp = pg_mass_texpon(Z);
+    int count = 1;
+
+    while (true) {
+        double X;
+        if (unif() < ptexp)
+            X = PG_TRUNC + expon_rate(1.0) / fz;
+        else
+            X = rtigauss(mu, 1.0, PG_TRUNC);
+
+        double S = pg_a(0, X);
+        double Y = unif() * S;
+        int n = 0;
+
+        while (true) {
+            ++n;
+            if (n % 2 == 1) {
+                S -= pg_a(n, X);
+                if (Y <= S) return 0.25 * X;
+            }
+            else {
+                S += pg_a(n, X);
+                if (Y > S) break;
+            }
+        }
+
+        check_R_interupt(count++);
+    }
+} // pg_devroye
+
+//------------------------------------------------------------------------------
+		    // Truncated sum of gammas //
+
+template<typename Engine>
+double RNGT<Engine>::pg_sum(double b, double z)
+{
+    // PG(b, z) = 1/(2 pi^2) sum_k g_k / ((k-1/2)^2 + z^2/(4 pi^2)), g_k ~ Ga(b,1).
+    // Replace the terms past PG_SUM_TERMS by their mean.
+    double c   = z*z / (4 * M_PI*M_PI);
+    double sum = 0.0;
+    for (int k = 1; k <= PG_SUM_TERMS; k++)
+        sum += gamma_rate(b, 1.0) / ((k - 0.5) * (k - 0.5) + c);
+
+    double K    = PG_SUM_TERMS;
+    double tail = c > 0 ? (0.5 * M_PI - atan(K / sqrt(c))) / sqrt(c) : 1.0 / K;
+
+    return (sum + b * tail) / (2 * M_PI*M_PI);
+}
+
+//------------------------------------------------------------------------------
+		      // Normal approximation //
+
+template<typename Engine>
+double RNGT<Engine>::pg_normal(double b, double z)
+{
+    z = fabs(z);
+    double m, v;
+    if (z < 1e-4) {
+        m = b / 4.0;
+        v = b / 24.0;
+    }
+    else {
+        double sech = 1.0 / cosh(0.5 * z);
+        m = 0.5 * b / z * tanh(0.5 * z);
+        v = 0.25 * b / (z*z*z) * (sinh(z) - z) * sech * sech;
+    }
+
+    double X = -1.0;
+    while (X <= 0) X = norm(m, sqrt(v));
+    return X;
+}
+
+//------------------------------------------------------------------------------
+		     // Saddle point approximation //
+
+// y(v) = tan(sqrt(v)) / sqrt(v), continued to v < 0 by tanh, is the mean of
+// the tilted J^*(1, .) distribution.  The saddle point solves y(v) = x.
+
+inline double pg_y_func(double v)
+{
+    double r = sqrt(fabs(v));
+    if (v > 1e-6)
+        return tan(r) / r;
+    else if (v < -1e-6)
+        return tanh(r) / r;
+    return 1.0 + v / 3.0 + 2.0 / 15.0 * v*v + 17.0 / 315.0 * v*v*v;
+}
+
+inline double pg_y_deriv(double v)
+{
+    double r = sqrt(fabs(v));
+    if (v > 1e-6) {
+        double c = cos(r);
+        return (r / (c*c) - tan(r)) / (2 * r*r*r);
+    }
+    else if (v < -1e-6) {
+        double sech = 1.0 / cosh(r);
+        return (tanh(r) - r * sech*sech) / (2 * r*r*r);
+    }
+    return 1.0 / 3.0 + 4.0 / 15.0 * v + 17.0 / 105.0 * v*v;
+}
+
+// Invert y by Newton's method, falling back to bisection when a step
+// leaves the bracket.  y is increasing on (-inf, pi^2/4).
+inline double pg_v_eval(double y)
+{
+    if (y == 1.0) return 0.0;
+
+    double lo = y > 1.0 ? 0.0 : -1.0 / (y*y);
+    double hi = y > 1.0 ? 0.25 * M_PI*M_PI : 0.0;
+    double v  = 3.0 * (y - 1.0);
+    if (v <= lo || v >= hi) v = 0.5 * (lo + hi);
+
+    for (int i = 0; i < 200; i++) {
+        double f = pg_y_func(v) - y;
+        if (fabs(f) <= 1e-12 * y) break;
+        if (f < 0) lo = v; else hi = v;
+        double nv = v - f / pg_y_deriv(v);
+        v = (nv > lo && nv < hi) ? nv : 0.5 * (lo + hi);
+        if (hi - lo < 1e-15 * (1.0 + fabs(v))) break;
+    }
+    return v;
+}
+
+inline double pg_cos_rt(double v)
+{
+    double r = sqrt(fabs(v));
+    return v >= 0 ? cos(r) : cosh(r);
+}
+
+// K''(t) at the saddle point, in terms of x and v.
+inline double pg_K2(double x, double v)
+{
+    if (fabs(v) >= 1e-6)
+        return x*x + (1 - x) / v;
+    return x*x - 1.0 / 3.0 - (2.0 / 15.0) * v;
+}
+
+// log of the saddle point approximation to the density of J^*(n, z) / n.
+inline double pg_log_sp(double x, double n, double z)
+{
+    double v   = pg_v_eval(x);
+    double t   = 0.5 * v + 0.5 * z*z;
+    double phi = log_cosh(z) - log(pg_cos_rt(v)) - t * x;
+    return 0.5 * log(0.5 * n / M_PI) - 0.5 * log(pg_K2(x, v)) + n * phi;
+}
+
+// Line tangent at x to eta = phi - delta, where delta is the log of the
+// inverse Gaussian (x < mid) or gamma (x >= mid) kernel.
+inline void pg_tangent(double x, double z, double mid, double& slope, double& icept)
+{
+    double v   = pg_v_eval(x);
+    double t   = 0.5 * v + 0.5 * z*z;
+    double phi = log_cosh(z) - log(pg_cos_rt(v)) - t * x;
+
+    double delta, ddelta;
+    if (x >= mid) {
+        delta  = log(x) - log(mid);
+        ddelta = 1.0 / x;
+    }
+    else {
+        delta  = 0.5 * (1 - 1.0 / x) - 0.5 * (1 - 1.0 / mid);
+        ddelta = 0.5 / (x*x);
+    }
+
+    slope = -t - ddelta;
+    icept = phi - delta - slope * x;
+}
+
+template<typename Engine>
+double RNGT<Engine>::pg_sp(double n, double z)
+{
+    z = 0.5 * fabs(z);
+
+    double xl = pg_y_func(-1 * z*z);    // Mean of J^*(1, z).
+    double md = xl * 1.1;               // Mid point.
+    double xr = xl * 1.2;               // Right point.
+
+    // Inflation constants.
+    double K2md = pg_K2(md, pg_v_eval(md));
+    double m2   = md * md;
+    double al   = m2 * md / K2md;
+    double ar   = m2 / K2md;
+
+    // Tangent lines on either side of md.
+    double sl, il, sr, ir;
+    pg_tangent(xl, z, md, sl, il);
+    pg_tangent(xr, z, md, sr, ir);
+    double rl = -1. * sl;
+    double rr = -1. * sr;
+
+    double lcn   = 0.5 * log(0.5 * n / M_PI);
+    double rt2rl = sqrt(2 * rl);
+
+    // Mass of each piece of the envelope, in logs.
+    double lwl = 0.5 * log(al) - n * rt2rl + n * il + 0.5 * n / md
+        + log(p_igauss(md, 1. / rt2rl, n));
+    double lwr = 0.5 * log(ar) + lcn - n * log(n * rr) + n * ir - n * log(md)
+        + Gamma(n, true) + log(1.0 - p_gamma_rate(md, n, n * rr));
+    double pl  = 1.0 / (1.0 + exp(lwr - lwl));
+
+    double X = 0.0;
+    int count = 1;
+
+    while (true) {
+        double lF;
+        if (unif() < pl) {
+            X  = rtigauss(1. / rt2rl, n, md);
+            lF = 0.5 * log(al) + lcn - 1.5 * log(X)
+                + n * (il - rl * X) + 0.5 * n * ((1. - 1./X) - (1. - 1./md));
+        }
+        else {
+            X  = ltgamma(n, n * rr, md);
+            lF = 0.5 * log(ar) + lcn + n * (ir - rr * X) + n * (log(X) - log(md)) - log(X);
+        }
+
+        if (log(unif()) + lF < pg_log_sp(X, n, z)) break;
+        check_R_interupt(count++);
+    }
+
+    return n * 0.25 * X;
+} // pg_sp
+
+//------------------------------------------------------------------------------
+
+template<typename Engine>
+double RNGT<Engine>::polyagamma(double b, double z)
+{
+    if (b <= 0) {
+        fprintf(stderr, "RNG::polyagamma: b=%g.\n", b);
+        TREOR("RNG::polyagamma: b must be positive.\n", 0.0);
+    }
+
+    if (b > PG_NORM_MIN) return pg_normal(b, z);
+    if (b >= PG_SP_MIN)  return pg_sp(b, z);
+
+    int    nb   = (int)floor(b);
+    double frac = b - nb;
+    double X    = 0.0;
+    for (int i = 0; i < nb; i++)
+        X += pg_devroye(z);
+    if (frac > 0)
+        X += pg_sum(frac, z);
+    return X;
+}
+
+#undef PG_TRUNC
+#undef PG_SP_MIN
+#undef PG_NORM_MIN
+#undef PG_SUM_TERMS
+
+//////////////////////////////////////////////////////////////////////
+		// CATEGORICAL, DIRICHLET, MULTINOMIAL //
+//////////////////////////////////////////////////////////////////////
+
+template<typename Engine>
+int RNGT<Engine>::categorical(const double* p, int K)
+{
+    double total = 0.0;
+    for (int i = 0; i < K; i++) total += p[i];
+
+    if (!(total > 0)) {
+        fprintf(stderr, "RNG::categorical: sum of weights is %g.\n", total);
+        TREOR("RNG::categorical: parameter problem.\n", 0);
+    }
+
+    double u = unif() * total;
+    double c = 0.0;
+    for (int i = 0; i < K - 1; i++) {
+        c += p[i];
+        if (u < c) return i;
+    }
+    return K - 1;
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Engine>
+int RNGT<Engine>::categorical_log(const double* lw, int K)
+{
+    double mx = -HUGE_VAL;
+    for (int i = 0; i < K; i++)
+        mx = lw[i] > mx ? lw[i] : mx;
+
+    if (!(mx > -HUGE_VAL) || mx == HUGE_VAL) {
+        fprintf(stderr, "RNG::categorical_log: max log weight is %g.\n", mx);
+        TREOR("RNG::categorical_log: parameter problem.\n", 0);
+    }
+
+    std::vector<double> c(K);
+    double total = 0.0;
+    for (int i = 0; i < K; i++) {
+        total += exp(lw[i] - mx);
+        c[i]   = total;
+    }
+
+    double u = unif() * total;
+    for (int i = 0; i < K - 1; i++)
+        if (u < c[i]) return i;
+    return K - 1;
+}
+
+//------------------------------------------------------------------------------
+
+// Normalized gammas.  For alpha < 1 most of the mass of Ga(alpha, 1) is
+// near zero and the draw can underflow, leaving 0 / 0.  Use
+// Ga(alpha) = Ga(alpha+1) U^{1/alpha} on the log scale and subtract the
+// largest log before exponentiating.  log U is drawn as -E, E ~ Exp(1),
+// which is never -inf.
+
+template<typename Engine>
+void RNGT<Engine>::dirichlet(double* x, const double* alpha, int K)
+{
+    double mx = -HUGE_VAL;
+    for (int i = 0; i < K; i++) {
+        if (alpha[i] < 1.0)
+            x[i] = log(gamma_rate(alpha[i] + 1.0, 1.0)) - expon_rate(alpha[i]);
+        else
+            x[i] = log(gamma_rate(alpha[i], 1.0));
+        mx = x[i] > mx ? x[i] : mx;
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < K; i++) {
+        x[i]   = exp(x[i] - mx);
+        total += x[i];
+    }
+    for (int i = 0; i < K; i++)
+        x[i] /= total;
+}
+
+//------------------------------------------------------------------------------
+
+// n_k | n_1, ..., n_{k-1} ~ Bin(N - sum_{j<k} n_j, p_k / sum_{j>=k} p_j).
+
+template<typename Engine>
+void RNGT<Engine>::multinomial(int* n, int N, const double* p, int K)
+{
+    if (K <= 0) return;
+
+    double mass = 0.0;
+    for (int i = 0; i < K; i++) mass += p[i];
+
+    int left = N;
+    for (int i = 0; i < K - 1; i++) {
+        if (left == 0 || !(mass > 0)) {
+            n[i] = 0;
+            continue;
+        }
+        double q = p[i] / mass;
+        n[i]  = q < 1.0 ? binom(left, q) : left;
+        left -= n[i];
+        mass -= p[i];
+    }
+    n[K-1] = left;
+}
+
+//////////////////////////////////////////////////////////////////////
+			 // BULK BERNOULLI //
+//////////////////////////////////////////////////////////////////////
+
+// Binary expansion of p in [0, 1), most significant bit first.  Doubling
+// and subtracting is exact in floating point.  Returns the number of
+// bits up to and including the last one that is set.
+
+inline int bern_expansion(double p, unsigned char* pbit, int maxbits)
+{
+    int last = 0;
+    for (int k = 0; k < maxbits && p > 0; k++) {
+        p *= 2.0;
+        pbit[k] = p >= 1.0;
+        if (pbit[k]) {
+            p   -= 1.0;
+            last = k + 1;
+        }
+    }
+    return last;
+}
+
+// 32 draws at once.  Lane j is decided at the first bit where U_j and p
+// differ: U_j < p if that bit of p is 1.  Lanes that agree with p up to
+// its last set bit have U_j >= p.
+
+template<typename Engine>
+inline uint32_t bern_word(Engine& r, const unsigned char* pbit, int nbit)
+{
+    uint32_t res = 0;
+    uint32_t und = 0xFFFFFFFFu;
+    for (int k = 0; k < nbit && und; k++) {
+        uint32_t W = r.bits32();
+        if (pbit[k]) {
+            res |= und & ~W;
+            und &= W;
+        }
+        else
+            und &= ~W;
+    }
+    return res;
+}
+
+template<typename Engine>
+void RNGT<Engine>::bern_mask(uint32_t* mask, int n, double p)
+{
+    int nwords = (n + 31) / 32;
+    int tail   = n % 32;
+
+    if (p <= 0.0 || p >= 1.0) {
+        uint32_t fill = p >= 1.0 ? 0xFFFFFFFFu : 0;
+        for (int i = 0; i < nwords; i++) mask[i] = fill;
+    }
+    else {
+        unsigned char pbit[64];
+        int nbit = bern_expansion(p, pbit, 64);
+        for (int i = 0; i < nwords; i++)
+            mask[i] = bern_word(*this, pbit, nbit);
+    }
+
+    if (tail) mask[nwords-1] &= (1u << tail) - 1;
+}
+
+template<typename Engine>
+void RNGT<Engine>::bern_bytes(unsigned char* x, int n, double p)
+{
+    if (p <= 0.0 || p >= 1.0) {
+        unsigned char fill = p >= 1.0;
+        for (int i = 0; i < n; i++) x[i] = fill;
+        return;
+    }
+
+    unsigned char pbit[64];
+    int nbit = bern_expansion(p, pbit, 64);
+
+    for (int start = 0; start < n; start += 32) {
+        uint32_t m   = bern_word(*this, pbit, nbit);
+        int      len = n - start < 32 ? n - start : 32;
+        for (int j = 0; j < len; j++)
+            x[start+j] = (m >> j) & 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// One draw with its own p, taking bits from buf as needed.
+
+template<typename Engine>
+int RNGT<Engine>::bern_bits(double p, uint32_t& buf, int& left)
+{
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) return 1;
+
+    while (p > 0) {
+        p *= 2.0;
+        int pk = p >= 1.0;
+        p -= pk;
+
+        if (left == 0) {
+            buf  = bits32();
+            left = 32;
+        }
+        int u = buf & 1;
+        buf >>= 1;
+        left--;
+
+        if (u != pk) return pk;
+    }
+    return 0;
+}
+
+template<typename Engine>
+void RNGT<Engine>::bern_mask(uint32_t* mask, int n, const double* p)
+{
+    uint32_t buf  = 0;
+    int      left = 0;
+    for (int start = 0; start < n; start += 32) {
+        uint32_t m   = 0;
+        int      len = n - start < 32 ? n - start : 32;
+        for (int j = 0; j < len; j++)
+            m |= (uint32_t)bern_bits(p[start+j], buf, left) << j;
+        mask[start/32] = m;
+    }
+}
+
+template<typename Engine>
+void RNGT<Engine>::bern_bytes(unsigned char* x, int n, const double* p)
+{
+    uint32_t buf  = 0;
+    int      left = 0;
+    for (int i = 0; i < n; i++)
+        x[i] = bern_bits(p[i], buf, left);
+}
+
+//////////////////////////////////////////////////////////////////////
+			// POISSON AND BINOMIAL //
+//////////////////////////////////////////////////////////////////////
+
+// See Hormann, The transformed rejection method for generating Poisson
+// random variables (1993) and The generation of binomial random variates
+// (1993).  The constants below are his; PoisSetup and BinomSetup, in
+// RNG.cpp, compute the envelopes.
+
+template<typename Engine>
+int RNGT<Engine>::poisson(const PoisSetup& ps)
+{
+    if (ps.mu < 0) TREOR("RNG::poisson: bad setup.\n", 0);
+
+    int count = 1;
+
+    if (!ps.ptrs) {
+        int    k    = 0;
+        double prod = unif();
+        while (prod > ps.emu) {
+            prod *= unif();
+            k++;
+        }
+        return k;
+    }
+
+    while (true) {
+        double U  = unif() - 0.5;
+        double V  = unif();
+        double us = 0.5 - fabs(U);
+        double k  = floor((2 * ps.a / us + ps.b) * U + ps.mu + 0.43);
+
+        if (us >= 0.07 && V <= ps.vr) return (int)k;
+
+        if (k >= 0 && (us >= 0.013 || V <= us)) {
+            double lhs = log(V) + ps.log_inv_alpha - log(ps.a / (us * us) + ps.b);
+            if (lhs <= -ps.mu + k * ps.log_mu - RNGMath::lgamma(k + 1)) return (int)k;
+        }
+
+        check_R_interupt(count++);
+    }
+}
+
+template<typename Engine>
+int RNGT<Engine>::poisson(double mu)
+{
+    if (!(mu >= 0)) {
+        fprintf(stderr, "RNG::poisson: mu=%g.\n", mu);
+        TREOR("RNG::poisson: parameter problem.\n", 0);
+    }
+    return poisson(PoisSetup(mu));
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Engine>
+int RNGT<Engine>::binom(const BinomSetup& bs)
+{
+    if (bs.n < 0) TREOR("RNG::binom: bad setup.\n", 0);
+
+    int n     = bs.n;
+    int k     = 0;
+    int count = 1;
+
+    if (!bs.btrs) {
+        double u = unif();
+        double f = bs.q_n;
+        while (u > f && k < n) {
+            u -= f;
+            k++;
+            f *= bs.r * (n - k + 1) / k;
+        }
+    }
+    else {
+        while (true) {
+            double U  = unif() - 0.5;
+            double V  = unif();
+            double us = 0.5 - fabs(U);
+            double kd = floor((2 * bs.a / us + bs.b) * U + bs.c);
+
+            if (kd >= 0 && kd <= n) {
+                if (us >= 0.07 && V <= bs.vr) { k = (int)kd; break; }
+
+                double lhs = log(V * bs.alpha / (bs.a / (us * us) + bs.b));
+                double rhs = bs.h - RNGMath::lgamma(kd + 1) - RNGMath::lgamma(n - kd + 1)
+                    + (kd - bs.m) * bs.lpq;
+                if (lhs <= rhs) { k = (int)kd; break; }
+            }
+
+            check_R_interupt(count++);
+        }
+    }
+
+    return bs.flip ? n - k : k;
+}
+
+template<typename Engine>
+int RNGT<Engine>::binom(int n, double p)
+{
+    if (n < 0 || !(p >= 0 && p <= 1)) {
+        fprintf(stderr, "RNG::binom: n=%i, p=%g.\n", n, p);
+        TREOR("RNG::binom: parameter problem.\n", 0);
+    }
+    return binom(BinomSetup(n, p));
+}
+
+//------------------------------------------------------------------------------
+
+template<typename Engine>
+int RNGT<Engine>::negbin(double size, double p)
+{
+    if (!(size > 0) || !(p > 0 && p <= 1)) {
+        fprintf(stderr, "RNG::negbin: size=%g, p=%g.\n", size, p);
+        TREOR("RNG::negbin: parameter problem.\n", 0);
+    }
+    if (p == 1.0) return 0;
+    return poisson(gamma_rate(size, p / (1.0 - p)));
+}
+
+#endif
@@ -91,6 +91,7 @@ ONEP(ExponMean, expon_mean, mean)
 ONEP(ExponRate, expon_rate, rate)
 ONEP(ChiSq    , chisq     , df  )
 ONEP(Norm1    , norm      , sd  )
+ONEP(Poisson  , poisson   , mu  )
 
 #undef ONEP
 
@@ -106,6 +107,9 @@ TWOP(GammaScale, gamma_scale, shape,  scale)
 TWOP(GammaRate , gamma_rate , shape,  scale)
 TWOP(IGamma    , igamma     , shape,  scale)
 TWOP(Flat      , flat       ,     a,      b)
+TWOP(PolyaGamma, polyagamma ,     b,      z)
+TWOP(Binom     , binom      ,     n,      p)
+TWOP(NegBin    , negbin     ,  size,      p)
 
 #undef TWOP
 
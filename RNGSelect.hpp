@@ -0,0 +1,136 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Algorithm selection for tnorm and rtgamma_rate.
+
+  Every kernel of tnorm is valid for every interval, and both kernels
+  of rtgamma_rate for every shape and rate; they only differ in speed.
+  The choice is looked up in a table over a grid of the parameters:
+
+    tnorm(left)           left                  tn1_table
+    tnorm(left, right)    left x log(width)     tn2_table
+    rtgamma_rate(a, b, 1) log(a) x log(b)       rtg_table
+
+  The cell holds the kernel with the least expected cost,
+
+    cost = c0 + c1 / acceptance rate,
+
+  worst case over the corners of the cell, with c0 and c1 measured for
+  each kernel on the target machine.  The acceptance rates are known in
+  closed form.  calibrate does the measuring and writes the tables to
+  RNGSelectTables.hpp:
+
+    make calibrate && ./calibrate > RNGSelectTables.hpp
+
+  The tables shipped are the fixed rules that came before, from
+  calibrate -d.  A cell that a rule's boundary crosses holds SEL_RULE
+  and the rule is evaluated there, as it is outside the grid, so the
+  choice, and the draws, are the same as before everywhere:
+
+    tnorm        left >= 0 : expon if right > lowerbound(left), else flat
+                 left <  0 : flat if width < sqrt(2 pi), else norm
+    rtgamma_rate reject if P(Ga(a, b) < 1) > 0.95, else beta
+
+  A lookup is a subtraction, a multiplication, and a load, plus a log
+  of the width or of the shape and rate, in place of an exp and a sqrt
+  in tnorm and of the gamma CDF in rtgamma_rate.
+
+*********************************************************************/
+
+#ifndef __RNGSELECT__
+#define __RNGSELECT__
+
+#include <cmath>
+
+enum TNormAlg   {TN_NORM=0, TN_EXPON=1, TN_FLAT=2, TN_NALG=3};
+enum RTGammaAlg {RTG_REJECT=0, RTG_BETA=1, RTG_NALG=2};
+
+// A cell that defers to the rule.
+const unsigned char SEL_RULE = 255;
+
+// rtgamma_rate's rule outside the table.
+const double RTG_REJECT_P = 0.95;
+
+struct SelectTable {
+  int    nx;
+  int    ny;
+  double x0, x1;
+  double y0, y1;
+  const unsigned char* cell;    // nx x ny, row major.
+};
+
+// The algorithm in the cell holding (x, y), -1 outside the grid or
+// in a SEL_RULE cell.
+inline int select_pick(const SelectTable& T, double x, double y)
+{
+  if (!(x >= T.x0 && x < T.x1 && y >= T.y0 && y < T.y1)) return -1;
+  int i = (int)((x - T.x0) * (T.nx / (T.x1 - T.x0)));
+  int j = (int)((y - T.y0) * (T.ny / (T.y1 - T.y0)));
+  if (i >= T.nx) i = T.nx - 1;
+  if (j >= T.ny) j = T.ny - 1;
+  int alg = T.cell[i * T.ny + j];
+  return alg == SEL_RULE ? -1 : alg;
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // Fixed Rules //
+//////////////////////////////////////////////////////////////////////
+
+inline int tnorm_rule(double left)
+{
+  return left < 0 ? TN_NORM : TN_EXPON;
+}
+
+inline int tnorm_rule(double left, double right)
+{
+  if (left >= 0) {
+    double astar  = 0.5 * (left + sqrt(left*left + 4));
+    double lbound = left + exp(0.5 * + 0.5 * left * (left - astar)) / astar;
+    return right > lbound ? TN_EXPON : TN_FLAT;
+  }
+  return right - left < 2.50662827 ? TN_FLAT : TN_NORM;
+}
+
+#include "RNGSelectTables.hpp"
+
+//////////////////////////////////////////////////////////////////////
+			    // Selection //
+//////////////////////////////////////////////////////////////////////
+
+inline int select_tnorm(double left)
+{
+  int alg = select_pick(tn1_table, left, 0.5);
+  return alg < 0 ? tnorm_rule(left) : alg;
+}
+
+// For right >= 0; tnorm reflects the interval otherwise.
+inline int select_tnorm(double left, double right)
+{
+  int alg = select_pick(tn2_table, left, log(right - left));
+  return alg < 0 ? tnorm_rule(left, right) : alg;
+}
+
+// Truncation at 1.  -1 outside the table or in a split cell: use the
+// CDF.
+inline int select_rtgamma(double shape, double rate)
+{
+  return select_pick(rtg_table, log(shape), log(rate));
+}
+
+#endif
@@ -18,21 +18,26 @@
 
 // YOU MUST ALWAYS CALL GetRNGSeed() and PutRNGSeed() WHEN USING THESE FUNCTIONS!!!
 
+// RRNG is an engine for RNGT that draws from R's generator.  Everything
+// is inline so that it may be inlined into RNGT's samplers.
+
 //////////////////////////////////////////////////////////////////////
 
-#ifndef __BASICRNG__
-#define __BASICRNG__
+#ifndef __RRNG__
+#define __RRNG__
 
+#include <stdint.h>
 #include "R.h"
 #include "Rmath.h"
 // #include "Matrix.h"
 
-class BasicRNG {
+class RRNG {
 
  public:
 
   // Random variates.
   double unif  ();                             // Uniform
+  uint32_t bits32();                           // 32 random bits
   double expon_mean(double mean);                  // Exponential
   double expon_rate(double rate);                  // Exponential
   double chisq (double df);                    // Chisq
@@ -45,6 +50,7 @@ class BasicRNG {
   double beta  (double a=1.0, double b=1.0);   // Beta
 
   int bern  (double p);                     // Bernoulli
+  int binom (int n, double p);              // Binomial
 
   // CDF
   static double p_norm (double x, int use_log=0);
@@ -56,6 +62,141 @@ class BasicRNG {
   // Utility
   static double Gamma (double x, int use_log=0);
 
-}; // BasicRNG
+}; // RRNG
+
+
+//////////////////////////////////////////////////////////////////////
+		      // R Random Variates //
+//////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------
+// Distributions with one parameter.
+
+#define ONEP(NAME, CALL, P1)			\
+  inline double RRNG::NAME(double P1)	\
+  {						\
+    return CALL (P1);				\
+  }						\
+
+ONEP(expon_mean, rexp  , mean)
+ONEP(chisq     , rchisq, df  )
+
+#undef ONEP
+
+//--------------------------------------------------------------------
+// Distributions with two parameters.
+
+#define TWOP(NAME, CALL, P1, P2)			\
+  inline double RRNG::NAME(double P1, double P2)	\
+  {							\
+    return CALL (P1, P2);				\
+  }							\
+
+TWOP(gamma_scale, rgamma, shape, scale)
+TWOP(norm      , rnorm , mean , sd  )
+TWOP(flat      , runif , a    , b   )
+TWOP(beta      , rbeta , a    , b   )
+
+// x ~ Gamma(shape=a, scale=b)
+// x ~ x^{a-1} exp(x / b).
+
+#undef TWOP
+
+//--------------------------------------------------------------------
+			    // Uniform //
+
+inline double RRNG::unif()
+{
+  return unif_rand();
+} // unif
+
+// R does not expose the raw generator output.  unif_rand carries 32 bits
+// for the default Mersenne Twister.
+inline uint32_t RRNG::bits32()
+{
+  return (uint32_t)(unif_rand() * 4294967296.0);
+} // bits32
+
+//--------------------------------------------------------------------
+			  // Exponential //
+inline double RRNG::expon_rate(double rate)
+{
+  return expon_mean(1.0 / rate);
+}
+
+//--------------------------------------------------------------------
+			    // Normal //
+
+inline double RRNG::norm(double sd)
+{
+  return rnorm(0, sd);
+} // norm
+
+//--------------------------------------------------------------------
+			   // Bernoulli //
+
+inline int RRNG::bern(double p)
+{
+  return (int)rbinom(1, p);
+}
+
+//--------------------------------------------------------------------
+			   // Binomial //
+
+inline int RRNG::binom(int n, double p)
+{
+  return (int)rbinom(n, p);
+}
+
+//--------------------------------------------------------------------
+			   // gamma_rate //
+
+inline double RRNG::gamma_rate(double shape, double rate)
+{
+  return gamma_scale(shape, 1.0 / rate);
+}
+
+//--------------------------------------------------------------------
+			   // Inv-Gamma //
+
+// a = shape, b = scale
+// x ~ IG(shape, scale) ~ x^{-a-1} exp(b / x).
+// => 1/x ~ Ga(shape, scale*=1/scale).
+
+inline double RRNG::igamma(double shape, double scale)
+{
+  return 1.0/rgamma(shape, 1.0 / scale);
+} // igamma
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline double RRNG::p_norm(double x, int use_log)
+{
+  return pnorm(x, 0.0, 1.0, 1, use_log);
+}
+
+inline double RRNG::p_gamma_rate(double x, double shape, double rate, int use_log)
+{
+  double scale = 1.0 / rate;
+  return pgamma(x, shape, scale, 1, use_log);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline double RRNG::Gamma (double x, int use_log)
+{
+  double y = lgammafn(x);
+  if (!use_log) y = exp(y);
+  return y;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline double RRNG::d_beta(double x, double a, double b)
+{
+  return dbeta(x, a, b, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
 #endif
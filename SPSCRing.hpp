@@ -0,0 +1,149 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Single producer / single consumer rings of doubles, shared by
+  BufferedRNG, whose rings live in the process, and ShmRNG, whose rings
+  live in shared memory.
+
+  The consumer writes the head and the producer the tail.  Each index
+  is written by one side only and published behind a memory barrier,
+  so neither side takes a lock.  The indices run freely and are
+  reduced mod the capacity, a power of two, only to address the
+  buffer: head == tail is empty, tail - head == capacity is full.
+
+  The producer asks ring_room where to write, fills up to RING_CHUNK
+  places without wrapping, and publishes them with ring_push.  The
+  consumer reads through a RingReader, which keeps private copies of
+  both indices and publishes its head every RING_PUBLISH reads.  What
+  either side does while it waits on the other is up to the engine.
+
+  RingIndex holds no pointers, so it can sit in shared memory; the
+  buffer is passed in.
+
+*********************************************************************/
+
+#ifndef __SPSCRING__
+#define __SPSCRING__
+
+#include <stdint.h>
+
+// Flush the consumer's head to the producer every so many reads.
+#define RING_PUBLISH 64
+
+// Largest number of values made before they are published.
+#define RING_CHUNK 256
+
+// head and tail on their own cache lines.
+struct RingIndex {
+  volatile uint32_t head;       // Written by the consumer.
+  char pad0[60];
+  volatile uint32_t tail;       // Written by the producer.
+  char pad1[60];
+};
+
+//////////////////////////////////////////////////////////////////////
+			     // Producer //
+//////////////////////////////////////////////////////////////////////
+
+// The number of places free from the tail, at most RING_CHUNK and not
+// past the end of the buffer, and in at the offset of the first.
+
+inline uint32_t ring_room(const RingIndex& R, uint32_t capacity, uint32_t& at)
+{
+  uint32_t t    = R.tail;
+  uint32_t room = capacity - (t - R.head);
+  at = t & (capacity - 1);
+  if (room > RING_CHUNK) room = RING_CHUNK;
+  // Do not wrap within a chunk.
+  if (room > capacity - at) room = capacity - at;
+  return room;
+}
+
+inline void ring_push(RingIndex& R, uint32_t n)
+{
+  // The writes to the buffer must be visible before the new tail.
+  __sync_synchronize();
+  R.tail = R.tail + n;
+}
+
+// What the consumer has yet to read, as far as the producer knows.
+inline uint32_t ring_level(const RingIndex& R)
+{
+  return R.tail - R.head;
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Consumer //
+//////////////////////////////////////////////////////////////////////
+
+class RingReader {
+
+ protected:
+
+  RingIndex*    idx;
+  const double* buf;
+  uint32_t      mask;
+  uint32_t      head;           // Consumer's private copies.
+  uint32_t      tail;
+
+ public:
+
+  RingReader() : idx(0), buf(0), mask(0), head(0), tail(0) {}
+
+  // Start where the last consumer of R left off.
+  void attach(RingIndex* R, const double* buffer, uint32_t capacity)
+  {
+    idx  = R;
+    buf  = buffer;
+    mask = capacity - 1;
+    head = tail = R->head;
+  }
+
+  // Empty as far as the consumer knows.
+  bool empty() const { return head == tail; }
+
+  // The next value.  Check empty first.
+  double next() { return buf[head++ & mask]; }
+
+  // Whether the head is due to be published.
+  bool due() const { return (head & (RING_PUBLISH - 1)) == 0; }
+
+  // Give back everything read so far.
+  void publish()
+  {
+    __sync_synchronize();
+    idx->head = head;
+  }
+
+  // Look for values published since the last look.  Return whether
+  // there are any.
+  bool refresh()
+  {
+    if ((tail = idx->tail) == head) return false;
+    // Do not read the slots before the tail that covers them.
+    __sync_synchronize();
+    return true;
+  }
+
+  // What the producer has published and the consumer not yet read.
+  uint32_t level() const { return idx->tail - head; }
+
+}; // RingReader
+
+#endif
@@ -0,0 +1,179 @@
+// -*- c-basic-offset: 4; -*-
+#include "ShmRNG.hpp"
+#include "RNGImpl.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <cstdio>
+
+// A seed for the local generator that differs between processes.
+static unsigned long local_seed()
+{
+    unsigned long s = 0;
+    FILE* f = fopen("/dev/urandom", "rb");
+    if (f) {
+	size_t got = fread(&s, sizeof(s), 1, f);
+	fclose(f);
+	if (got == 1) return s;
+    }
+    return (unsigned long)time(NULL) * 2654435761ul ^ ((unsigned long)getpid() << 16);
+}
+
+// Whether process pid exists.
+static bool pid_alive(int32_t pid)
+{
+    return pid > 0 && !(kill(pid, 0) != 0 && errno == ESRCH);
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+ShmEngine::ShmEngine(const char* name)
+    : hdr(NULL)
+    , bytes(0)
+    , slot(NULL)
+    , id(-1)
+    , attached(false)
+{
+    #ifndef USE_R
+    fallback.set(local_seed());
+    #endif
+
+    if (!attach(name)) {
+	fprintf(stderr, "ShmEngine: no producer at %s; drawing locally.\n", name);
+	return;
+    }
+    if (!claim()) {
+	fprintf(stderr, "ShmEngine: every slot of %s is taken; drawing locally.\n", name);
+	detach();
+	return;
+    }
+    attached = true;
+}
+
+ShmEngine::~ShmEngine()
+{
+    if (slot) {
+	// Give back what was read, so the next owner starts after it.
+	for (int k = 0; k < SHM_NKIND; k++)
+	    reader[k].publish();
+	__sync_synchronize();
+	slot->owner = 0;
+    }
+    detach();
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Attach //
+//////////////////////////////////////////////////////////////////////
+
+bool ShmEngine::attach(const char* name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmHeader)) {
+	close(fd);
+	return false;
+    }
+
+    bytes = st.st_size;
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+	bytes = 0;
+	return false;
+    }
+    hdr = (ShmHeader*)p;
+
+    if (hdr->magic != SHM_MAGIC || hdr->version != SHM_VERSION || !producer_alive()
+	|| bytes < shm_size(hdr->nslots, hdr->capacity)) {
+	detach();
+	return false;
+    }
+
+    return true;
+}
+
+void ShmEngine::detach()
+{
+    if (hdr) munmap(hdr, bytes);
+    hdr   = NULL;
+    slot  = NULL;
+    bytes = 0;
+}
+
+// Take the first free slot, or the first one whose owner has died.  A
+// dead owner may have read up to RING_PUBLISH variates past the head it
+// published, so skip those.
+
+bool ShmEngine::claim()
+{
+    int32_t pid = (int32_t)getpid();
+
+    for (uint32_t i = 0; i < hdr->nslots; i++) {
+	ShmSlot* S     = shm_slot(hdr, i);
+	int32_t  owner = S->owner;
+	bool     stale = owner != 0 && !pid_alive(owner);
+
+	if ((owner == 0 || stale) && __sync_bool_compare_and_swap(&S->owner, owner, pid)) {
+	    slot = S;
+	    id   = i;
+	    __sync_synchronize();
+	    for (int k = 0; k < SHM_NKIND; k++)
+		reader[k].attach(&S->ring[k], shm_buffer(hdr, i, k), hdr->capacity);
+	    if (stale) {
+		attached = true;
+		for (int k = 0; k < SHM_NKIND; k++)
+		    for (int j = 0; j < RING_PUBLISH; j++)
+			pop(k);
+		attached = false;
+	    }
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Consumer //
+//////////////////////////////////////////////////////////////////////
+
+// The producer stopped, or died without saying so.
+bool ShmEngine::producer_alive() const
+{
+    return hdr->alive && pid_alive(hdr->producer);
+}
+
+// Give back everything read so far and wait for more.  Return false if
+// the producer is gone.
+
+bool ShmEngine::wait(int kind)
+{
+    RingReader& R = reader[kind];
+
+    R.publish();
+    while (!R.refresh()) {
+	if (!producer_alive()) {
+	    fprintf(stderr, "ShmEngine: the producer has stopped; drawing locally.\n");
+	    attached = false;
+	    return false;
+	}
+	sched_yield();
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Instantiate //
+//////////////////////////////////////////////////////////////////////
+
+template class RNGT<ShmEngine>;
@@ -0,0 +1,181 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Variates served through POSIX shared memory.
+
+  Many single threaded processes on one host can share one producer,
+  shm_producer, which runs on a spare core:
+
+    shm_producer -n /grng -s 32 -c 65536 -S 1234 &
+
+  It creates the segment /grng with 32 slots.  Each slot has a ring of
+  uniforms, one of standard normals, and one of standard exponentials,
+  65536 each.  The producer keeps every ring full, filling them in turn
+  from one generator per kind of variate.  The slots therefore hold
+  disjoint pieces of the same three streams and no two processes ever
+  see the same variate.  The seed is the producer's; the clients do not
+  seed at all.
+
+  A client constructs ShmRNG = RNGT<ShmEngine>, which claims a free
+  slot.  The slot of a process that has died is reclaimed.  unif,
+  norm, and expon read the rings in place, with the single producer /
+  single consumer protocol of SPSCRing.hpp that BufferedRNG uses.  The other variates are
+  built on these through EngineBase.  If there is no producer, or it
+  goes away, ShmEngine says so and draws from a BasicRNG of its own.
+  That is seeded from /dev/urandom, or from the pid and the time, so
+  no two processes share a stream then either.  A producer that was
+  killed is noticed through its pid, and the next producer removes
+  the segment it left behind.
+
+  The layout of the segment is below.  It holds no pointers, since
+  each process maps it at its own address.  head and tail sit on their
+  own cache lines.
+
+    ShmHeader | ShmSlot[nslots] | double[nslots][SHM_NKIND][capacity]
+
+*********************************************************************/
+
+#ifndef __SHMRNG__
+#define __SHMRNG__
+
+#include "RNG.hpp"
+#include "EngineBase.hpp"
+#include "SPSCRing.hpp"
+#include <stdint.h>
+
+#define SHM_DEFAULT_NAME "/grng"
+#define SHM_MAGIC        0x474e5247u
+#define SHM_VERSION      2
+
+enum ShmKind {SHM_UNIF=0, SHM_NORM=1, SHM_EXPON=2, SHM_NKIND=3};
+
+//////////////////////////////////////////////////////////////////////
+			      // Layout //
+//////////////////////////////////////////////////////////////////////
+
+typedef RingIndex ShmRing;
+
+struct ShmSlot {
+  volatile int32_t owner;       // pid of the client, 0 if free.
+  char pad[60];
+  ShmRing ring[SHM_NKIND];
+};
+
+struct ShmHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t nslots;
+  uint32_t capacity;            // Power of two.
+  unsigned long seed;
+  volatile uint32_t alive;      // Cleared when the producer stops.
+  volatile int32_t  producer;   // pid of the producer.
+  char pad[32];
+};
+
+inline size_t shm_size(uint32_t nslots, uint32_t capacity)
+{
+  return sizeof(ShmHeader) + nslots * sizeof(ShmSlot)
+    + (size_t)nslots * SHM_NKIND * capacity * sizeof(double);
+}
+
+inline double* shm_buffer(ShmHeader* hdr, uint32_t slot, int kind)
+{
+  char* base = (char*)hdr + sizeof(ShmHeader) + hdr->nslots * sizeof(ShmSlot);
+  return (double*)base + ((size_t)slot * SHM_NKIND + kind) * hdr->capacity;
+}
+
+inline ShmSlot* shm_slot(ShmHeader* hdr, uint32_t slot)
+{
+  return (ShmSlot*)((char*)hdr + sizeof(ShmHeader)) + slot;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Client //
+//////////////////////////////////////////////////////////////////////
+
+class ShmEngine : public EngineBase<ShmEngine> {
+
+ protected:
+
+  ShmHeader* hdr;
+  size_t     bytes;
+  ShmSlot*   slot;
+  int        id;
+  bool       attached;
+
+  RingReader reader[SHM_NKIND];
+
+  BasicRNG fallback;
+
+  bool attach(const char* name);
+  bool claim();
+  void detach();
+  bool wait(int kind);
+  bool producer_alive() const;
+
+  double local(int kind)
+  {
+    switch (kind) {
+    case SHM_NORM:
+      return fallback.norm(1.0);
+    case SHM_EXPON:
+      return fallback.expon_rate(1.0);
+    default:
+      return fallback.unif();
+    }
+  }
+
+  double pop(int kind);
+
+  // Not copyable: the slot belongs to one engine.
+  ShmEngine(const ShmEngine&);
+  ShmEngine& operator=(const ShmEngine&);
+
+ public:
+
+  ShmEngine(const char* name=SHM_DEFAULT_NAME);
+  ~ShmEngine();
+
+  bool is_attached() const { return attached; }
+  int  slot_id() const { return id; }
+
+  double unif() { return pop(SHM_UNIF); }
+  double norm(double sd) { return sd * pop(SHM_NORM); }
+  double norm(double mean, double sd) { return mean + sd * pop(SHM_NORM); }
+  double expon_rate(double rate) { return pop(SHM_EXPON) / rate; }
+  double expon_mean(double mean) { return mean * pop(SHM_EXPON); }
+
+}; // ShmEngine
+
+typedef RNGT<ShmEngine> ShmRNG;
+
+inline double ShmEngine::pop(int kind)
+{
+    if (!attached) return local(kind);
+
+    RingReader& R = reader[kind];
+    if (R.empty() && !wait(kind))
+	return local(kind);
+
+    double x = R.next();
+    if (R.due()) R.publish();
+    return x;
+}
+
+#endif
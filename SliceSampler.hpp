@@ -0,0 +1,150 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Univariate slice sampling.
+
+  Neal (2003), stepping out and shrinkage.  Each draw is one Markov
+  transition from the current state, which need not be log concave or
+  normalized, so use it for a full conditional inside a Gibbs sampler
+  when ARS does not apply.  The log density at the current state is
+  kept between draws, so a transition costs the evaluations needed to
+  step out and shrink and no more.
+
+  LogDens is any functor with
+
+    double operator()(double x) const;
+
+  returning log f(x) up to a constant.  -inf outside the support is
+  fine.
+
+    SliceSampler<MyDens> ss(dens, x0, w);
+    double x = ss.draw(r);
+    ss.draw(r, X, n, thin);     // n states, every thin-th transition.
+
+  w is a guess at the width of the slice and m * w the most the
+  interval may grow.
+
+*********************************************************************/
+
+#ifndef __SLICESAMPLER__
+#define __SLICESAMPLER__
+
+#include "RNG.hpp"
+#include <cmath>
+#include <cstdio>
+
+template<typename LogDens>
+class SliceSampler {
+
+ protected:
+
+  LogDens f;
+  double  w;
+  int     m;
+  double  lower;
+  double  upper;
+
+  double  x0;                   // Current state.
+  double  h0;                   // f at x0.
+
+ public:
+
+  SliceSampler(const LogDens& f, double x0, double w=1.0, int m=100,
+	       double lower=-HUGE_VAL, double upper=HUGE_VAL);
+
+  void   set_state(double x);
+  double state() const { return x0; }
+  void   set_width(double w_) { w = w_; }
+
+  template<typename Engine> double draw(RNGT<Engine>& r);
+  template<typename Engine> void   draw(RNGT<Engine>& r, double* X, int n, int thin=1);
+
+}; // SliceSampler
+
+//////////////////////////////////////////////////////////////////////
+
+template<typename LogDens>
+SliceSampler<LogDens>::SliceSampler(const LogDens& f_, double x0_, double w_, int m_,
+				    double lower_, double upper_)
+  : f(f_)
+  , w(w_)
+  , m(m_)
+  , lower(lower_)
+  , upper(upper_)
+{
+  set_state(x0_);
+}
+
+template<typename LogDens>
+void SliceSampler<LogDens>::set_state(double x)
+{
+  x0 = x;
+  h0 = f(x);
+  if (!(h0 > -HUGE_VAL))
+    fprintf(stderr, "SliceSampler: log density at %g is %g.\n", x, h0);
+}
+
+template<typename LogDens> template<typename Engine>
+double SliceSampler<LogDens>::draw(RNGT<Engine>& r)
+{
+  // The slice {x : f(x) > y}.
+  double y = h0 - r.expon_rate(1.0);
+
+  // Step out from a randomly placed interval.
+  double L = x0 - w * r.unif();
+  double R = L + w;
+  int    J = (int)(m * r.unif());
+  int    K = m - 1 - J;
+
+  while (J > 0 && L > lower && f(L) > y) {
+    L -= w;
+    J--;
+  }
+  while (K > 0 && R < upper && f(R) > y) {
+    R += w;
+    K--;
+  }
+  if (L < lower) L = lower;
+  if (R > upper) R = upper;
+
+  // Shrink toward x0 until a point lands in the slice.
+  while (true) {
+    double x1 = L + r.unif() * (R - L);
+    double h1 = f(x1);
+    if (h1 > y) {
+      x0 = x1;
+      h0 = h1;
+      return x0;
+    }
+    if (x1 < x0) L = x1;
+    else         R = x1;
+  }
+}
+
+template<typename LogDens> template<typename Engine>
+void SliceSampler<LogDens>::draw(RNGT<Engine>& r, double* X, int n, int thin)
+{
+  for (int i = 0; i < n; i++) {
+    for (int t = 0; t < thin; t++)
+      draw(r);
+    X[i] = x0;
+  }
+}
+
+#endif
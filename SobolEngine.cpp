@@ -0,0 +1,130 @@
+// -*- c-basic-offset: 4; -*-
+#include "SobolEngine.hpp"
+#include "RNGImpl.hpp"
+
+//////////////////////////////////////////////////////////////////////
+		       // Direction Numbers //
+//////////////////////////////////////////////////////////////////////
+
+// Joe and Kuo, Constructing Sobol sequences with better two-dimensional
+// projections (2008), new-joe-kuo-6.21201, dimensions 2 through 21.  The
+// primitive polynomial has degree s and inner coefficients a; m holds the
+// initial direction numbers.
+
+struct SobolPoly {
+    int s;
+    int a;
+    int m[7];
+};
+
+static const SobolPoly sobol_poly[SobolEngine::MAXDIM - 1] = {
+    {1,  0, {1}},
+    {2,  1, {1, 3}},
+    {3,  1, {1, 3, 1}},
+    {3,  2, {1, 1, 1}},
+    {4,  1, {1, 1, 3, 3}},
+    {4,  4, {1, 3, 5, 13}},
+    {5,  2, {1, 1, 5, 5, 17}},
+    {5,  4, {1, 1, 5, 5, 5}},
+    {5,  7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6,  1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+    {7,  4, {1, 3, 7, 13, 13, 15, 69}}
+};
+
+void SobolEngine::directions()
+{
+    // The first dimension is the van der Corput sequence.
+    for (int k = 0; k < NBITS; k++)
+	dir[0][k] = 1u << (NBITS - 1 - k);
+
+    for (int j = 1; j < d; j++) {
+	const SobolPoly& P = sobol_poly[j-1];
+	int s = P.s;
+	for (int k = 0; k < s; k++)
+	    dir[j][k] = (uint32_t)P.m[k] << (NBITS - 1 - k);
+	for (int k = s; k < NBITS; k++) {
+	    dir[j][k] = dir[j][k-s] ^ (dir[j][k-s] >> s);
+	    for (int i = 1; i < s; i++)
+		if ((P.a >> (s - 1 - i)) & 1)
+		    dir[j][k] ^= dir[j][k-i];
+	}
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+SobolEngine::SobolEngine(int dim, uint32_t seed_, uint32_t start)
+    : d(dim)
+    , cur(0)
+    , idx(0)
+{
+    if (d < 1 || d > MAXDIM) {
+	fprintf(stderr, "SobolEngine: dim=%i is not in 1..%i; clamping.\n", d, MAXDIM);
+	d = d < 1 ? 1 : MAXDIM;
+    }
+    directions();
+    set(seed_);
+    skip(start);
+}
+
+// fmix32 of MurmurHash3 on the seed and the dimension, so that nearby
+// seeds give unrelated scrambles.
+
+void SobolEngine::set(unsigned long seed_)
+{
+    seed = (uint32_t)seed_;
+    for (int j = 0; j < MAXDIM; j++) {
+	uint32_t h = seed ^ ((uint32_t)(j + 1) * 0x9E3779B9u);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	dseed[j] = h;
+    }
+    skip(0);
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // Skip Ahead //
+//////////////////////////////////////////////////////////////////////
+
+// Point n is the XOR of the direction numbers at the set bits of the
+// Gray code n ^ (n >> 1).  The plain sequence skips the origin.
+
+void SobolEngine::skip(uint32_t index)
+{
+    index += (seed == 0);
+    uint32_t g = index ^ (index >> 1);
+    for (int j = 0; j < d; j++) {
+	uint32_t v = 0;
+	for (int k = 0; k < NBITS; k++)
+	    if ((g >> k) & 1) v ^= dir[j][k];
+	pt[j] = v;
+    }
+    idx = index;
+    cur = 0;
+}
+
+void SobolEngine::block(unsigned int part, unsigned int nparts, uint32_t npoints)
+{
+    double start = (double)part * (double)npoints / (double)nparts;
+    skip((uint32_t)start);
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Instantiate //
+//////////////////////////////////////////////////////////////////////
+
+template class RNGT<SobolEngine>;
@@ -0,0 +1,164 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Scrambled Sobol points for randomized quasi-Monte Carlo.
+
+  SobolRNG = RNGT<SobolEngine> hands out the coordinates of a Sobol
+  sequence in dim <= 21 dimensions, in order: the first dim calls to
+  unif are the coordinates of point 0, the next dim those of point 1,
+  and so on.  A Monte Carlo integrand that uses dim uniforms per
+  replicate therefore gets one point per replicate.  Call next_point
+  to skip the coordinates of the current point that were not used.
+
+  Only the samplers that invert a CDF with one uniform are valid here:
+  unif, flat, norm, expon_rate, expon_mean, texpon_rate, bern, and
+  categorical.  Rejection samplers, e.g. gamma, tnorm, and poisson,
+  use up a varying number of coordinates and so read coordinates of
+  successive points, which are far from independent; their draws are
+  biased.  Use a pseudo random engine for those.
+
+  The direction numbers are those of Joe and Kuo (2008).  Points are
+  generated in Gray code order, one XOR per coordinate.  skip jumps
+  to any point in O(32 dim), and block splits the first npoints
+  points into contiguous pieces, e.g. one per OpenMP thread:
+
+    SobolRNG r(dim, seed);
+    r.block(omp_get_thread_num(), omp_get_num_threads(), N);
+
+  With a nonzero seed every coordinate is Owen scrambled with the hash
+  of Laine and Karras as given by Burley (2020).  The scrambled points
+  are uniform on the cube, so independent seeds give independent
+  estimates whose spread estimates the error.  Seed 0 is the plain
+  sequence without its first point, the origin, which is standard:
+  point i is then point i + 1 of the sequence, in skip, block, and
+  index as well.  The first 2^m - 1 points, with the origin, make a
+  balanced net, so use n = 2^m - 1 points rather than 2^m.  A uniform
+  is (x + 1/2) / 2^32 for a 32 bit coordinate x, so it is never 0 or
+  1.
+
+*********************************************************************/
+
+#ifndef __SOBOLENGINE__
+#define __SOBOLENGINE__
+
+#include "RNG.hpp"
+#include "EngineBase.hpp"
+
+class SobolEngine : public EngineBase<SobolEngine> {
+
+ public:
+
+  static const int MAXDIM = 21;
+  static const int NBITS  = 32;
+
+ protected:
+
+  int      d;                   // Dimension.
+  int      cur;                 // Next coordinate of the current point.
+  uint32_t idx;                 // Index of the current point in the sequence.
+  uint32_t pt[MAXDIM];          // Current point, unscrambled.
+  uint32_t dir[MAXDIM][NBITS];  // Direction numbers.
+
+  uint32_t seed;
+  uint32_t dseed[MAXDIM];       // Scrambling seed per dimension.
+
+  void directions();
+  void advance();
+
+  static uint32_t reverse(uint32_t v);
+  static uint32_t owen(uint32_t v, uint32_t s);
+
+ public:
+
+  SobolEngine(int dim=1, uint32_t seed=0, uint32_t start=0);
+
+  // Reseed the scrambling and go back to point 0.
+  void set(unsigned long seed);
+
+  // The next coordinate.
+  double unif();
+
+  // Point index; the remaining coordinates of the current point are
+  // dropped.
+  void skip(uint32_t index);
+  void next_point() { advance(); }
+
+  // Start at point floor(part * npoints / nparts).
+  void block(unsigned int part, unsigned int nparts, uint32_t npoints);
+
+  int      dim()   const { return d; }
+  uint32_t index() const { return idx - (seed == 0); }
+
+}; // SobolEngine
+
+typedef RNGT<SobolEngine> SobolRNG;
+
+//////////////////////////////////////////////////////////////////////
+			      // Inline //
+//////////////////////////////////////////////////////////////////////
+
+inline uint32_t SobolEngine::reverse(uint32_t v)
+{
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+// Nested uniform scramble: a Laine-Karras permutation of the reversed
+// bits only lets higher bits affect lower ones.
+
+inline uint32_t SobolEngine::owen(uint32_t v, uint32_t s)
+{
+    v  = reverse(v);
+    v += s;
+    v ^= v * 0x6c50b47cu;
+    v ^= v * 0xb82f1e52u;
+    v ^= v * 0xc7afe638u;
+    v ^= v * 0x8d22f6e6u;
+    return reverse(v);
+}
+
+// Gray code order: point n+1 differs from point n by the direction
+// number of the lowest zero bit of n.
+
+inline void SobolEngine::advance()
+{
+    uint32_t m = idx;
+    int      c = 0;
+    while (m & 1) {
+	m >>= 1;
+	c++;
+    }
+    if (c >= NBITS) c = NBITS - 1;  // Wrapped around after 2^32 points.
+    for (int j = 0; j < d; j++)
+	pt[j] ^= dir[j][c];
+    idx++;
+    cur = 0;
+}
+
+inline double SobolEngine::unif()
+{
+    uint32_t v = seed ? owen(pt[cur], dseed[cur]) : pt[cur];
+    if (++cur == d) advance();
+    return (v + 0.5) * 2.3283064365386963e-10;
+}
+
+#endif
@@ -0,0 +1,164 @@
+// -*- c-basic-offset: 4; -*-
+#include "TMVNorm.hpp"
+#include "LinAlg.hpp"
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+TMVNorm::TMVNorm()
+    : n(0)
+{
+    // Do nothing.
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Setup //
+//////////////////////////////////////////////////////////////////////
+
+void TMVNorm::set_prec(const double* Prec, int d)
+{
+    n = d;
+    P.assign(Prec, Prec + d*d);
+
+    ipdiag.resize(d);
+    sd.resize(d);
+    for (int i = 0; i < d; i++) {
+	ipdiag[i] = 1.0 / P[i*d+i];
+	sd[i]     = sqrt(ipdiag[i]);
+    }
+
+    m.assign(d, 0.0);
+    lower.assign(d, -HUGE_VAL);
+    upper.assign(d,  HUGE_VAL);
+    kind.assign(d, TMV_NONE);
+    x.assign(d, 0.0);
+    r.assign(d, 0.0);
+}
+
+bool TMVNorm::set_cov(const double* V, int d)
+{
+    std::vector<double> A(V, V + d*d);
+
+    char uplo = 'L';
+    int  info = 0;
+    dpotrf_(&uplo, &d, &A[0], &d, &info);
+    if (info == 0) dpotri_(&uplo, &d, &A[0], &d, &info);
+
+    if (info != 0) {
+	fprintf(stderr, "TMVNorm: covariance is not positive definite, info=%i.\n", info);
+	n = 0;
+	return false;
+    }
+
+    // dpotri only fills the lower triangle.
+    for (int j = 1; j < d; j++)
+	for (int i = 0; i < j; i++)
+	    A[j*d+i] = A[i*d+j];
+
+    set_prec(&A[0], d);
+    return true;
+}
+
+void TMVNorm::set_bounds(const double* lower_, const double* upper_)
+{
+    for (int i = 0; i < n; i++) {
+	lower[i] = lower_ ? lower_[i] : -HUGE_VAL;
+	upper[i] = upper_ ? upper_[i] :  HUGE_VAL;
+
+	if (lower[i] > upper[i]) {
+	    fprintf(stderr, "TMVNorm::set_bounds: lower[%i]=%g > upper[%i]=%g.\n", i, lower[i], i, upper[i]);
+	    upper[i] = lower[i];
+	}
+
+	kind[i] = (lower[i] > -HUGE_VAL ? TMV_LOWER : TMV_NONE)
+	        | (upper[i] <  HUGE_VAL ? TMV_UPPER : TMV_NONE);
+
+	if (x[i] < lower[i]) x[i] = lower[i];
+	if (x[i] > upper[i]) x[i] = upper[i];
+    }
+    refresh();
+}
+
+void TMVNorm::set_mean(const double* mean)
+{
+    m.assign(mean, mean + n);
+    refresh();
+}
+
+bool TMVNorm::set_state(const double* x0)
+{
+    for (int i = 0; i < n; i++) {
+	if (x0[i] < lower[i] || x0[i] > upper[i]) {
+	    fprintf(stderr, "TMVNorm::set_state: x0[%i]=%g is not in [%g, %g].\n", i, x0[i], lower[i], upper[i]);
+	    return false;
+	}
+    }
+    x.assign(x0, x0 + n);
+    refresh();
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Gibbs //
+//////////////////////////////////////////////////////////////////////
+
+void TMVNorm::refresh()
+{
+    for (int i = 0; i < n; i++) r[i] = 0.0;
+    for (int j = 0; j < n; j++) {
+	double        dj = x[j] - m[j];
+	const double* Pj = &P[j*n];
+	for (int i = 0; i < n; i++)
+	    r[i] += Pj[i] * dj;
+    }
+}
+
+inline void TMVNorm::update(RNG& rng, int i)
+{
+    double mi = x[i] - r[i] * ipdiag[i];
+    double xi;
+
+    switch (kind[i]) {
+    case TMV_LOWER:
+	xi = rng.tnorm(lower[i], mi, sd[i]);
+	break;
+    case TMV_UPPER:
+	xi = -1.0 * rng.tnorm(-1.0 * upper[i], -1.0 * mi, sd[i]);
+	break;
+    case TMV_BOTH:
+	xi = rng.tnorm(lower[i], upper[i], mi, sd[i]);
+	break;
+    default:
+	xi = rng.norm(mi, sd[i]);
+    }
+
+    double        delta = xi - x[i];
+    const double* Pi    = &P[i*n];
+    for (int j = 0; j < n; j++)
+	r[j] += Pi[j] * delta;
+    x[i] = xi;
+}
+
+void TMVNorm::sweep(RNG& rng)
+{
+    for (int i = 0; i < n; i++)
+	update(rng, i);
+}
+
+void TMVNorm::draw(RNG& rng, double* X, int K, int thin)
+{
+    if (n == 0) {
+	fprintf(stderr, "TMVNorm::draw: no covariance or precision set.\n");
+	return;
+    }
+
+    refresh();
+
+    for (int k = 0; k < K; k++) {
+	for (int t = 0; t < thin; t++)
+	    sweep(rng);
+	for (int i = 0; i < n; i++)
+	    X[k*n+i] = x[i];
+    }
+}
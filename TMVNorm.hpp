@@ -0,0 +1,104 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Truncated multivariate normal by Gibbs sampling.
+
+  X ~ N(m, P^{-1}) restricted to the box lower <= X <= upper.  Given the
+  others, coordinate i is a univariate truncated normal with
+
+    sd_i   = 1 / sqrt(P_ii)
+    mean_i = m_i - (1/P_ii) sum_{j != i} P_ij (x_j - m_j)
+           = x_i - r_i / P_ii,          r = P (x - m).
+
+  TMVNorm keeps the residual r.  When x_i moves by delta, r changes by
+  delta times column i of P, so a coordinate update is O(d) and the
+  conditional regressions never have to be rebuilt from a covariance.
+  r is recomputed from scratch whenever the mean, bounds, or state are
+  set and at the start of every call to draw so that rounding does not
+  pile up.
+
+  Each coordinate's truncation is classified once, when the bounds are
+  set, as none, lower, upper, or both, and the update calls norm or the
+  matching version of RNG::tnorm directly.  Use -HUGE_VAL and HUGE_VAL
+  for missing bounds.
+
+  P, X, and the state are column-major double arrays.
+
+*********************************************************************/
+
+#ifndef __TMVNORM__
+#define __TMVNORM__
+
+#include "RNG.hpp"
+#include <vector>
+
+class TMVNorm {
+
+ public:
+
+  enum Bound {TMV_NONE=0, TMV_LOWER=1, TMV_UPPER=2, TMV_BOTH=3};
+
+ protected:
+
+  int n;
+
+  std::vector<double> P;      // Precision, d x d.
+  std::vector<double> ipdiag; // 1 / P_ii.
+  std::vector<double> sd;     // 1 / sqrt(P_ii).
+  std::vector<double> m;      // Mean.
+  std::vector<double> lower;
+  std::vector<double> upper;
+  std::vector<int>    kind;   // Bound.
+
+  std::vector<double> x;      // Current state.
+  std::vector<double> r;      // P (x - m).
+
+  void refresh();
+  void update(RNG& rng, int i);
+
+ public:
+
+  TMVNorm();
+
+  // Precision or covariance.  Bounds default to none, the mean to 0,
+  // and the state to the mean.  Return false if V is not positive
+  // definite.
+  void set_prec(const double* Prec, int d);
+  bool set_cov (const double* V, int d);
+
+  // NULL means -HUGE_VAL or HUGE_VAL throughout.  Moves the state into
+  // the box if it is not there already.
+  void set_bounds(const double* lower_, const double* upper_);
+  void set_mean  (const double* mean);
+
+  // Start from x0, which must lie in the box.
+  bool set_state (const double* x0);
+
+  int dim() const { return n; }
+  const double* state() const { return &x[0]; }
+
+  // One Gibbs sweep in coordinate order.
+  void sweep(RNG& rng);
+
+  // X (d x K): the state after every thin sweeps.
+  void draw(RNG& rng, double* X, int K, int thin=1);
+
+}; // TMVNorm
+
+#endif
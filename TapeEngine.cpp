@@ -0,0 +1,98 @@
+// -*- c-basic-offset: 4; -*-
+#include "TapeEngine.hpp"
+#include "RNGImpl.hpp"
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+TapeEngine::TapeEngine()
+    : mode(TAPE_LIVE)
+    , upos(0)
+    , zpos(0)
+{
+    // Do nothing.
+}
+
+TapeEngine::TapeEngine(unsigned long seed)
+    : mode(TAPE_LIVE)
+    , upos(0)
+    , zpos(0)
+{
+    set(seed);
+}
+
+// R has one generator, seeded from R.
+
+void TapeEngine::set(unsigned long seed)
+{
+    #ifndef USE_R
+    base.set(seed);
+    #endif
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Tape //
+//////////////////////////////////////////////////////////////////////
+
+void TapeEngine::record()
+{
+    clear();
+    mode = TAPE_RECORD;
+}
+
+void TapeEngine::replay(bool antithetic)
+{
+    upos = 0;
+    zpos = 0;
+    mode = antithetic ? TAPE_ANTITHETIC : TAPE_REPLAY;
+}
+
+void TapeEngine::clear()
+{
+    utape.clear();
+    ztape.clear();
+    upos = 0;
+    zpos = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Gamma //
+//////////////////////////////////////////////////////////////////////
+
+// Marsaglia and Tsang as in EngineBase, except that only the first
+// proposal comes from the tape.
+
+double TapeEngine::gamma_scale(double shape, double scale)
+{
+    if (mode == TAPE_LIVE)
+	return EngineBase<TapeEngine>::gamma_scale(shape, scale);
+
+    double boost = 1.0;
+    if (shape < 1.0) {
+	boost  = pow(unif(), 1.0 / shape);
+	shape += 1.0;
+    }
+
+    double d = shape - 1.0 / 3.0;
+    double c = 1.0 / sqrt(9.0 * d);
+    double x = norm(1.0);
+    double u = unif();
+
+    while (true) {
+	double v = 1.0 + c * x;
+	if (v > 0) {
+	    v = v * v * v;
+	    if (u < 1.0 - 0.0331 * x * x * x * x) return scale * boost * d * v;
+	    if (log(u) < 0.5 * x * x + d * (1.0 - v + log(v))) return scale * boost * d * v;
+	}
+	x = base.norm(1.0);
+	u = base_unif();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // Instantiate //
+//////////////////////////////////////////////////////////////////////
+
+template class RNGT<TapeEngine>;
@@ -0,0 +1,150 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Common random numbers and antithetic variates.
+
+  TapeRNG = RNGT<TapeEngine> takes its uniforms and standard normals
+  from a BasicRNG and can record them on a tape.  Everything else,
+  exponentials, gammas, truncated normals, and so on, is built from
+  those two through EngineBase, so replaying the tape replays every
+  draw made from it:
+
+    TapeRNG r(seed);
+    r.record();
+    r.norm(X, mu1, sd);         // Draws and records.
+    r.replay();
+    r.norm(Y, mu2, sd);         // Same normals as X: common numbers.
+    r.replay(true);
+    r.norm(Z, mu1, sd);         // Antithetic: Z - mu1 = -(X - mu1).
+
+  A replay hands out U and Z as recorded or, when antithetic, 1 - U
+  and -Z, and draws nothing from the generator.  Samplers that invert
+  a CDF, e.g. flat, expon, and norm, give exactly antithetic pairs.
+  The gamma, and so gamma_rate, chisq, and beta, takes one normal and
+  one uniform from the tape per draw and any retries from the
+  generator, so a rejection does not put the rest of an array out of
+  step.  Other rejection samplers, e.g. tnorm, give pairs that are
+  valid but only partly coupled: once one side rejects where the other
+  accepts, the two read different parts of the tape.  A replay that
+  runs past the end of the tape draws fresh variates and appends them,
+  so later replays stay in step.
+
+  In live mode, the default, nothing is recorded.
+
+*********************************************************************/
+
+#ifndef __TAPEENGINE__
+#define __TAPEENGINE__
+
+#include "RNG.hpp"
+#include "EngineBase.hpp"
+#include <vector>
+
+class TapeEngine : public EngineBase<TapeEngine> {
+
+ public:
+
+  enum Mode {TAPE_LIVE=0, TAPE_RECORD=1, TAPE_REPLAY=2, TAPE_ANTITHETIC=3};
+
+ protected:
+
+  BasicRNG base;
+  Mode     mode;
+
+  std::vector<double> utape;
+  std::vector<double> ztape;
+  size_t upos;
+  size_t zpos;
+
+  // A uniform in (0, 1), so that U and 1 - U are both positive and
+  // expon and the like stay finite on either side of a pair.
+  double base_unif()
+  {
+    double u;
+    do u = base.unif(); while (u == 0.0);
+    return u;
+  }
+
+ public:
+
+  TapeEngine();
+  explicit TapeEngine(unsigned long seed);
+
+  // Seed the generator; the tape is kept.
+  void set(unsigned long seed);
+
+  // Start a new tape.
+  void record();
+
+  // Rewind and replay the tape, or its antithetic counterpart.
+  void replay(bool antithetic=false);
+
+  // Stop recording or replaying.
+  void live() { mode = TAPE_LIVE; }
+
+  // Throw the tape away.
+  void clear();
+
+  Mode   get_mode() const { return mode; }
+  size_t unif_recorded() const { return utape.size(); }
+  size_t norm_recorded() const { return ztape.size(); }
+
+  double unif();
+  double norm(double sd);
+  double norm(double mean, double sd) { return mean + norm(sd); }
+
+  double gamma_scale(double shape, double scale);
+
+}; // TapeEngine
+
+typedef RNGT<TapeEngine> TapeRNG;
+
+//////////////////////////////////////////////////////////////////////
+			      // Inline //
+//////////////////////////////////////////////////////////////////////
+
+inline double TapeEngine::unif()
+{
+    if (mode == TAPE_LIVE) return base_unif();
+
+    if (mode == TAPE_RECORD || upos == utape.size()) {
+	utape.push_back(base_unif());
+	upos = utape.size();
+	return mode == TAPE_ANTITHETIC ? 1.0 - utape.back() : utape.back();
+    }
+
+    double u = utape[upos++];
+    return mode == TAPE_ANTITHETIC ? 1.0 - u : u;
+}
+
+inline double TapeEngine::norm(double sd)
+{
+    if (mode == TAPE_LIVE) return base.norm(sd);
+
+    if (mode == TAPE_RECORD || zpos == ztape.size()) {
+	ztape.push_back(base.norm(1.0));
+	zpos = ztape.size();
+	return mode == TAPE_ANTITHETIC ? -sd * ztape.back() : sd * ztape.back();
+    }
+
+    double z = ztape[zpos++];
+    return mode == TAPE_ANTITHETIC ? -sd * z : sd * z;
+}
+
+#endif
@@ -0,0 +1,159 @@
+// -*- c-basic-offset: 4; -*-
+#include "Wishart.hpp"
+#include "LinAlg.hpp"
+
+//////////////////////////////////////////////////////////////////////
+			  // Constructors //
+//////////////////////////////////////////////////////////////////////
+
+Wishart::Wishart()
+    : n(0)
+    , inv(false)
+{
+    // Do nothing.
+}
+
+Wishart::Wishart(const double* S, int d, bool inverse)
+    : n(0)
+    , inv(inverse)
+{
+    if (inverse)
+	set_inv_scale(S, d);
+    else
+	set_scale(S, d);
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Factor //
+//////////////////////////////////////////////////////////////////////
+
+bool Wishart::factor(const double* A, int d)
+{
+    L.assign(A, A + d*d);
+
+    char uplo = 'L';
+    int  info = 0;
+    dpotrf_(&uplo, &d, &L[0], &d, &info);
+
+    if (info != 0) {
+	fprintf(stderr, "Wishart: matrix is not positive definite, info=%i.\n", info);
+	// Do not leave a partial factor for chol().
+	L.clear();
+	n = 0;
+	return false;
+    }
+
+    // dpotrf leaves the upper triangle alone.
+    for (int j = 1; j < d; j++)
+	for (int i = 0; i < j; i++)
+	    L[j*d+i] = 0.0;
+
+    n = d;
+    return true;
+}
+
+bool Wishart::set_scale(const double* S, int d)
+{
+    inv = false;
+    return factor(S, d);
+}
+
+bool Wishart::set_inv_scale(const double* Psi, int d)
+{
+    inv = true;
+    if (!factor(Psi, d)) return false;
+
+    // Psi^{-1} from its factor, then factor that.
+    char uplo = 'L';
+    int  info = 0;
+    std::vector<double> P(L);
+    dpotri_(&uplo, &d, &P[0], &d, &info);
+
+    if (info != 0) {
+	fprintf(stderr, "Wishart: could not invert Psi, info=%i.\n", info);
+	L.clear();
+	n = 0;
+	return false;
+    }
+
+    return factor(&P[0], d);
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Draw //
+//////////////////////////////////////////////////////////////////////
+
+void Wishart::draw(RNG& r, double nu, double* X, int K, double* C) const
+{
+    if (n == 0) {
+	fprintf(stderr, "Wishart::draw: no scale set.\n");
+	return;
+    }
+
+    if (!(nu > n - 1)) {
+	fprintf(stderr, "Wishart::draw: need nu > d - 1, nu=%g, d=%i.\n", nu, n);
+	return;
+    }
+
+    int    d     = n;
+    int    dd    = d * d;
+    int    dK    = d * K;
+    int    info  = 0;
+    double one   = 1.0;
+    char   side  = 'L';
+    char   rside = 'R';
+    char   uplo  = 'L';
+    char   notr  = 'N';
+    char   tr    = 'T';
+    char   diag  = 'N';
+    double* Lp   = const_cast<double*>(&L[0]);
+
+    std::vector<double> work;
+    if (!C) {
+	work.resize(dd * K);
+	C = &work[0];
+    }
+
+    // The Bartlett factors, side by side in a d x dK block.  Column j of
+    // every A_k draws its chi-square with the same degrees of freedom.
+    for (int j = 0; j < d; j++) {
+	double df = nu - j;
+	for (int k = 0; k < K; k++) {
+	    double* A = C + k*dd + j*d;
+	    for (int i = 0; i < j; i++)
+		A[i] = 0.0;
+	    A[j] = sqrt(r.chisq(df));
+	    for (int i = j+1; i < d; i++)
+		A[i] = r.norm(1.0);
+	}
+    }
+
+    // C_k = L A_k, all at once.
+    dtrmm_(&side, &uplo, &notr, &diag, &d, &dK, &one, Lp, &d, C, &d);
+
+    if (!X) return;
+
+    for (int k = 0; k < K; k++) {
+	double* Xk = X + k*dd;
+	double* Ck = C + k*dd;
+	for (int i = 0; i < dd; i++)
+	    Xk[i] = Ck[i];
+
+	if (inv) {
+	    // X = (C C')^{-1}, lower triangle.
+	    dpotri_(&uplo, &d, Xk, &d, &info);
+	    if (info != 0) {
+		fprintf(stderr, "Wishart::draw: draw %i is singular, info=%i.\n", k, info);
+		return;
+	    }
+	}
+	else {
+	    // X = C C'.
+	    dtrmm_(&rside, &uplo, &tr, &diag, &d, &d, &one, Ck, &d, Xk, &d);
+	}
+
+	for (int j = 1; j < d; j++)
+	    for (int i = 0; i < j; i++)
+		Xk[j*d+i] = Xk[i*d+j];
+    }
+}
@@ -0,0 +1,84 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Wishart and inverse Wishart draws by the Bartlett decomposition.
+
+  If S = L L' and A is lower triangular with
+
+    A_jj ~ sqrt(chisq(nu - j)),  j = 0, ..., d-1,
+    A_ij ~ N(0, 1),              i > j,
+
+  then C = L A is the lower Cholesky factor of a W(nu, S) draw,
+  W = C C'.  Wishart caches L, so repeated draws never factor S again.
+  K draws at once put A_1, ..., A_K side by side and multiply them by
+  L with one level 3 BLAS call, as MVNorm does.
+
+  X ~ IW(nu, Psi) is the inverse of W(nu, Psi^{-1}).  set_inv_scale
+  factors Psi^{-1} once, C = L A is then the Cholesky factor of the
+  precision X^{-1}, and X comes from C by dpotri.
+
+  draw can hand back C as well as, or instead of, the draw.  A model
+  that goes on to use the covariance or precision in MVNorm, say, then
+  need not factor it again.
+
+  Every matrix is column-major, d x d; K of them are stored one after
+  another.  nu must exceed d - 1.
+
+*********************************************************************/
+
+#ifndef __WISHART__
+#define __WISHART__
+
+#include "RNG.hpp"
+#include <vector>
+
+class Wishart {
+
+ protected:
+
+  int  n;       // Dimension.
+  bool inv;     // Inverse Wishart?
+  std::vector<double> L;
+
+  bool factor(const double* A, int d);
+
+ public:
+
+  Wishart();
+  Wishart(const double* S, int d, bool inverse=false);
+
+  // Factor and cache.  Return false if S or Psi is not positive definite.
+  bool set_scale    (const double* S, int d);    // W(nu, S)
+  bool set_inv_scale(const double* Psi, int d);  // IW(nu, Psi)
+
+  int  dim() const { return n; }
+  bool is_inv() const { return inv; }
+
+  // Lower triangular factor of S, or of Psi^{-1}; NULL before a set or
+  // after one fails.
+  const double* chol() const { return L.empty() ? 0 : &L[0]; }
+
+  // X (d x d x K) ~ W(nu, S) or IW(nu, Psi).  If C is not NULL it gets
+  // the lower Cholesky factor of each W, or of each X^{-1}.  X may be
+  // NULL if only C is wanted.
+  void draw(RNG& r, double nu, double* X, int K=1, double* C=0) const;
+
+}; // Wishart
+
+#endif
@@ -0,0 +1,390 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Writes RNGSelectTables.hpp for this machine; see RNGSelect.hpp.
+
+    calibrate [-d] [-n draws] > RNGSelectTables.hpp
+
+  Each kernel is timed on two problems with known acceptance rates,
+  which gives c0 and c1 in cost = c0 + c1 / acceptance.  For
+  right_tgamma_beta the cost is c0 + c1 E[K], K the index of the beta
+  in its mixture.  Each cell then gets the kernel that is cheapest at
+  its worst corner.  -d writes the fixed rules instead, with no timing,
+  deferring to the rule itself in the cells a boundary crosses.
+
+*********************************************************************/
+
+#include "RNG.hpp"
+#include <sys/time.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+// Grids.  Outside them the fixed rules are used.
+const int    TN1_NX = 64;
+const double TN1_X0 = -4.0, TN1_X1 = 4.0;
+
+const int    TN2_NX = 32, TN2_NY = 40;
+const double TN2_X0 = -4.0, TN2_X1 = 4.0;    // left
+const double TN2_Y0 = -7.0, TN2_Y1 = 3.0;    // log(right - left)
+
+const int    RTG_NX = 40, RTG_NY = 48;
+const double RTG_X0 = -5.0, RTG_X1 = 5.0;    // log(shape)
+const double RTG_Y0 = -5.0, RTG_Y1 = 7.0;    // log(rate)
+
+//////////////////////////////////////////////////////////////////////
+		       // Acceptance Rates //
+//////////////////////////////////////////////////////////////////////
+
+// log P(left < Z < right).
+static double log_mass(double left, double right)
+{
+    if (left >= 0) {
+	double a = RNGMath::log_p_norm(-left);
+	double b = RNGMath::log_p_norm(-right);
+	return a + log1p(-exp(b - a));
+    }
+    if (right <= 0)
+	return log_mass(-right, -left);
+    return log(RNGMath::p_norm(right) - RNGMath::p_norm(left));
+}
+
+static double log_accept(int alg, double left, double right)
+{
+    double lZ = log_mass(left, right);
+    double w  = right - left;
+    switch (alg) {
+    case TN_NORM:
+	return lZ;
+    case TN_FLAT: {
+	if (w == HUGE_VAL) return -HUGE_VAL;
+	double m = left > 0 ? left : (right < 0 ? right : 0.0);
+	return 0.5 * log(2 * M_PI) + lZ + 0.5 * m * m - log(w);
+    }
+    default: {
+	double a = 0.5 * (left + sqrt(left*left + 4));
+	double d = w == HUGE_VAL ? 0.0 : log1p(-exp(-a * w));
+	return 0.5 * log(2 * M_PI) + lZ + log(a) + a * left - 0.5 * a * a - d;
+    }
+    }
+}
+
+// Mixture weights of right_tgamma_beta: E[K].
+static double mean_terms(double a, double b)
+{
+    double lp  = log(RNGMath::p_gamma(b, a, RNGMath::lgamma(a)));
+    double cum = 0.0, EK = 0.0;
+    for (int k = 1; k < 10000000 && cum < 1 - 1e-10; k++) {
+	double w = exp(-b + (a+k-1) * log(b) - RNGMath::lgamma(a+k) - lp);
+	cum += w;
+	EK  += k * w;
+    }
+    return EK;
+}
+
+static double p_reject(double a, double b)
+{
+    return RNGMath::p_gamma(b, a, RNGMath::lgamma(a));
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Timing //
+//////////////////////////////////////////////////////////////////////
+
+static double seconds(const timeval& t1, const timeval& t2)
+{
+    return t2.tv_sec - t1.tv_sec + (double)(t2.tv_usec - t1.tv_usec) / 1000000.0;
+}
+
+volatile double sink;
+
+// Nanoseconds per draw.
+static double time_tnorm(RNG& r, int alg, double left, double right, int n)
+{
+    timeval start, stop;
+    double  s = 0.0;
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < n; i++) {
+	switch (alg) {
+	case TN_NORM : s += r.tnorm_norm (left, right); break;
+	case TN_EXPON: s += r.tnorm_expon(left, right); break;
+	default      : s += r.tnorm_flat (left, right);
+	}
+    }
+    gettimeofday(&stop, NULL);
+    sink = s;
+    return 1e9 * seconds(start, stop) / n;
+}
+
+static double time_rtgamma(RNG& r, int alg, double a, double b, int n)
+{
+    timeval start, stop;
+    double  s = 0.0;
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < n; i++)
+	s += alg == RTG_REJECT ? r.right_tgamma_reject(a, b) : r.right_tgamma_beta(a, b);
+    gettimeofday(&stop, NULL);
+    sink = s;
+    return 1e9 * seconds(start, stop) / n;
+}
+
+// t = c0 + c1 z at two points.
+static void fit(double t1, double z1, double t2, double z2, double* c)
+{
+    c[1] = (t1 - t2) / (z1 - z2);
+    if (c[1] < 1e-3) c[1] = 1e-3;
+    c[0] = t1 - c[1] * z1;
+    if (c[0] < 0) c[0] = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Tables //
+//////////////////////////////////////////////////////////////////////
+
+static double tn_cost(const double c[][2], int alg, double left, double right)
+{
+    if (right < 0) {
+	double t = left;
+	left  = -right;
+	right = -t;
+    }
+    double la = log_accept(alg, left, right);
+    return c[alg][0] + c[alg][1] * exp(-la);
+}
+
+template<typename Cost>
+static int cheapest(int nalg, Cost cost)
+{
+    int    best = 0;
+    double min  = HUGE_VAL;
+    for (int alg = 0; alg < nalg; alg++) {
+	double v = cost(alg);
+	if (v < min) {
+	    min  = v;
+	    best = alg;
+	}
+    }
+    return best;
+}
+
+struct TN1Cost {
+    const double (*c)[2];
+    double l0, l1;
+    double operator()(int alg) const
+    { return std::max(tn_cost(c, alg, l0, HUGE_VAL), tn_cost(c, alg, l1, HUGE_VAL)); }
+};
+
+struct TN2Cost {
+    const double (*c)[2];
+    double l0, l1, w0, w1;
+    double operator()(int alg) const
+    {
+	return std::max(std::max(tn_cost(c, alg, l0, l0 + w0), tn_cost(c, alg, l0, l0 + w1)),
+			std::max(tn_cost(c, alg, l1, l1 + w0), tn_cost(c, alg, l1, l1 + w1)));
+    }
+};
+
+struct RTGCost {
+    const double (*c)[2];
+    double a[2], b[2];
+    double operator()(int alg) const
+    {
+	double worst = 0.0;
+	for (int i = 0; i < 2; i++)
+	    for (int j = 0; j < 2; j++) {
+		double z = alg == RTG_REJECT ? 1.0 / p_reject(a[i], b[j]) : mean_terms(a[i], b[j]);
+		worst = std::max(worst, c[alg][0] + c[alg][1] * z);
+	    }
+	return worst;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////
+			   // Fixed Rules //
+//////////////////////////////////////////////////////////////////////
+
+// -d samples the rule on a SUB x SUB grid over each cell, edges
+// included.  A cell the rule splits gets SEL_RULE, so the rule itself
+// is called there; the boundaries are monotone within a cell, so a
+// cell that agrees on the grid agrees everywhere.  For rtgamma the
+// cell is also split when P is within RTG_MARGIN of the cut, as the
+// sampler computes P by another route.
+const int    SUB        = 17;
+const double RTG_MARGIN = 1e-6;
+
+static int tn2_rule(double l, double w)
+{
+    double r = l + w;
+    return r < 0 ? tnorm_rule(-r, -l) : tnorm_rule(l, r);
+}
+
+static int rtg_rule(double a, double b)
+{
+    double p = p_reject(a, b);
+    if (fabs(p - RTG_REJECT_P) < RTG_MARGIN) return SEL_RULE;
+    return p > RTG_REJECT_P ? RTG_REJECT : RTG_BETA;
+}
+
+// The rule if it is the same over [x0, x1] x [y0, y1], else SEL_RULE.
+// expx and expy mark an axis on the log scale.
+template<typename Rule>
+static int rule_cell(Rule rule, double x0, double x1, double y0, double y1, bool expx, bool expy)
+{
+    int alg = -1;
+    for (int i = 0; i < SUB; i++)
+	for (int j = 0; j < SUB; j++) {
+	    double x = x0 + (x1 - x0) * i / (SUB - 1);
+	    double y = y0 + (y1 - y0) * j / (SUB - 1);
+	    int a = rule(expx ? exp(x) : x, expy ? exp(y) : y);
+	    if (a == SEL_RULE || (alg >= 0 && a != alg)) return SEL_RULE;
+	    alg = a;
+	}
+    return alg;
+}
+
+static int tn1_rule(double l, double) { return tnorm_rule(l); }
+
+static void print_table(const char* name, const vector<unsigned char>& cell, int nx, int ny,
+			double x0, double x1, double y0, double y1)
+{
+    printf("static const unsigned char %s_cells[%i] = {\n", name, nx * ny);
+    for (int i = 0; i < nx; i++) {
+	printf("  ");
+	for (int j = 0; j < ny; j++)
+	    printf("%i%s", cell[i*ny+j], (i == nx-1 && j == ny-1) ? "" : ",");
+	printf("\n");
+    }
+    printf("};\n");
+    printf("static const SelectTable %s_table = {%i, %i, %g, %g, %g, %g, %s_cells};\n\n",
+	   name, nx, ny, x0, x1, y0, y1, name);
+}
+
+int main(int argc, char** argv)
+{
+    bool fixed = false;
+    int  n     = 200000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "dn:")) != -1) {
+	switch (opt) {
+	case 'd': fixed = true; break;
+	case 'n': n = atoi(optarg); break;
+	default:
+	    fprintf(stderr, "usage: %s [-d] [-n draws] > RNGSelectTables.hpp\n", argv[0]);
+	    return 1;
+	}
+    }
+
+    double tc[TN_NALG][2];
+    double gc[RTG_NALG][2];
+
+    if (!fixed) {
+	RNG r(1);
+
+	// Two problems per kernel, with different acceptance rates.
+	double tp[TN_NALG][4] = {
+	    {-1.0,  1.0, 0.5, HUGE_VAL},   // norm
+	    { 0.0, HUGE_VAL, 0.0, 3.0},    // expon
+	    { 0.0,  0.5, -2.0, 2.0}        // flat
+	};
+	for (int alg = 0; alg < TN_NALG; alg++) {
+	    double* p  = tp[alg];
+	    double  t1 = time_tnorm(r, alg, p[0], p[1], n);
+	    double  t2 = time_tnorm(r, alg, p[2], p[3], n);
+	    fit(t1, exp(-log_accept(alg, p[0], p[1])), t2, exp(-log_accept(alg, p[2], p[3])), tc[alg]);
+	    fprintf(stderr, "tnorm kernel %i: %g + %g / acceptance ns\n", alg, tc[alg][0], tc[alg][1]);
+	}
+
+	double t1 = time_rtgamma(r, RTG_REJECT, 1.0, 8.0, n);
+	double t2 = time_rtgamma(r, RTG_REJECT, 1.0, 0.7, n);
+	fit(t1, 1.0 / p_reject(1.0, 8.0), t2, 1.0 / p_reject(1.0, 0.7), gc[RTG_REJECT]);
+	t1 = time_rtgamma(r, RTG_BETA, 1.0, 0.1, n);
+	t2 = time_rtgamma(r, RTG_BETA, 1.0, 20.0, n / 10);
+	fit(t1, mean_terms(1.0, 0.1), t2, mean_terms(1.0, 20.0), gc[RTG_BETA]);
+	fprintf(stderr, "rtgamma reject: %g + %g / p ns; beta: %g + %g E[K] ns\n",
+		gc[0][0], gc[0][1], gc[1][0], gc[1][1]);
+    }
+
+    printf("// Generated by calibrate%s; see RNGSelect.hpp.  Do not edit.\n", fixed ? " -d" : "");
+    if (fixed)
+	printf("// The fixed rules; %i marks a cell the rules split.\n", SEL_RULE);
+    else {
+	printf("// Costs in ns, c0 + c1 / acceptance:");
+	for (int alg = 0; alg < TN_NALG; alg++) printf(" %.3g %.3g,", tc[alg][0], tc[alg][1]);
+	printf(" rtgamma %.3g %.3g, %.3g %.3g.\n", gc[0][0], gc[0][1], gc[1][0], gc[1][1]);
+    }
+    printf("\n#ifndef __RNGSELECTTABLES__\n#define __RNGSELECTTABLES__\n\n");
+
+    // tnorm(left)
+    vector<unsigned char> cell(TN1_NX);
+    double dx = (TN1_X1 - TN1_X0) / TN1_NX;
+    for (int i = 0; i < TN1_NX; i++) {
+	double l0 = TN1_X0 + i * dx, l1 = l0 + dx;
+	if (fixed)
+	    cell[i] = rule_cell(tn1_rule, l0, l1, 0.0, 0.0, false, false);
+	else {
+	    TN1Cost cost = {tc, l0, l1};
+	    cell[i] = cheapest(TN_NALG, cost);
+	}
+    }
+    print_table("tn1", cell, TN1_NX, 1, TN1_X0, TN1_X1, 0.0, 1.0);
+
+    // tnorm(left, right)
+    cell.resize(TN2_NX * TN2_NY);
+    dx = (TN2_X1 - TN2_X0) / TN2_NX;
+    double dy = (TN2_Y1 - TN2_Y0) / TN2_NY;
+    for (int i = 0; i < TN2_NX; i++)
+	for (int j = 0; j < TN2_NY; j++) {
+	    double l0 = TN2_X0 + i * dx, l1 = l0 + dx;
+	    double w0 = exp(TN2_Y0 + j * dy), w1 = exp(TN2_Y0 + (j+1) * dy);
+	    if (fixed)
+		cell[i*TN2_NY+j] = rule_cell(tn2_rule, l0, l1, TN2_Y0 + j * dy, TN2_Y0 + (j+1) * dy,
+					     false, true);
+	    else {
+		TN2Cost cost = {tc, l0, l1, w0, w1};
+		cell[i*TN2_NY+j] = cheapest(TN_NALG, cost);
+	    }
+	}
+    print_table("tn2", cell, TN2_NX, TN2_NY, TN2_X0, TN2_X1, TN2_Y0, TN2_Y1);
+
+    // rtgamma_rate(a, b, 1)
+    cell.resize(RTG_NX * RTG_NY);
+    dx = (RTG_X1 - RTG_X0) / RTG_NX;
+    dy = (RTG_Y1 - RTG_Y0) / RTG_NY;
+    for (int i = 0; i < RTG_NX; i++)
+	for (int j = 0; j < RTG_NY; j++) {
+	    double a0 = exp(RTG_X0 + i * dx), a1 = exp(RTG_X0 + (i+1) * dx);
+	    double b0 = exp(RTG_Y0 + j * dy), b1 = exp(RTG_Y0 + (j+1) * dy);
+	    if (fixed)
+		cell[i*RTG_NY+j] = rule_cell(rtg_rule, RTG_X0 + i * dx, RTG_X0 + (i+1) * dx,
+					     RTG_Y0 + j * dy, RTG_Y0 + (j+1) * dy, true, true);
+	    else {
+		RTGCost cost = {gc, {a0, a1}, {b0, b1}};
+		cell[i*RTG_NY+j] = cheapest(RTG_NALG, cost);
+	    }
+	}
+    print_table("rtg", cell, RTG_NX, RTG_NY, RTG_X0, RTG_X1, RTG_Y0, RTG_Y1);
+
+    printf("#endif\n");
+    return 0;
+}
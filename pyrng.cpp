@@ -0,0 +1,526 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Python bindings: the module pyrng, with the types RNGPar and RNG.
+
+    import numpy as np, pyrng
+    r = pyrng.RNGPar(8, 1234)           # 8 threads, seed 1234.
+    x = np.empty(10**7)
+    r.norm(x, 0.0, 1.0)                 # In place, on 8 threads.
+    mu = np.linspace(0, 1, 1000)
+    r.norm(x.reshape(-1, 1000), mu, 2.0)
+
+  Every sampler fills its first argument in place.  That must be a
+  writable, C contiguous buffer of doubles, e.g. a float64 NumPy array
+  or array.array('d'); nothing is copied or returned.  A parameter is
+  a number or a contiguous buffer of doubles whose length divides the
+  length of the output.  It is recycled, which is NumPy's broadcasting
+  of a trailing axis, and read in place.  The GIL is released while
+  the draws are made.
+
+  RNGPar(nthread, seed) runs RNGPar<double>: stream i is seeded with
+  seed + i and every call splits the output among the threads.  RNG
+  (seed) is one stream with RNG's array samplers, including tnorm and
+  igauss.  Each object holds a lock while it draws, so calls on one
+  object from several Python threads take turns; use one object per
+  thread to draw in parallel.
+
+  Build with make pyrng.  Needs GSL.  make pycheck runs test_pyrng.py,
+  a quick check of the bindings.
+
+*********************************************************************/
+
+#include <Python.h>
+#include <pythread.h>
+#include "RNG.hpp"
+#include "CPURNG.hpp"
+#include <climits>
+#include <cstring>
+#include <vector>
+
+using std::vector;
+
+//////////////////////////////////////////////////////////////////////
+			    // Buffers //
+//////////////////////////////////////////////////////////////////////
+
+// The output, or a parameter: a number or a buffer of doubles.
+struct PyArg {
+    Py_buffer view;
+    bool      held;
+    double    v;
+    double*   p;
+    size_t    n;
+
+    PyArg() : held(false), v(0), p(&v), n(1) {}
+    ~PyArg() { if (held) PyBuffer_Release(&view); }
+
+    bool get(PyObject* obj, const char* name, bool out=false)
+    {
+	if (!out && PyNumber_Check(obj) && !PyObject_CheckBuffer(obj)) {
+	    v = PyFloat_AsDouble(obj);
+	    return !(v == -1.0 && PyErr_Occurred());
+	}
+
+	int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (out ? PyBUF_WRITABLE : 0);
+	if (PyObject_GetBuffer(obj, &view, flags) != 0) return false;
+	held = true;
+
+	if (view.itemsize != sizeof(double) || !view.format || strcmp(view.format, "d") != 0) {
+	    PyErr_Format(PyExc_TypeError, "%s must be a buffer of doubles.", name);
+	    return false;
+	}
+
+	p = (double*)view.buf;
+	n = view.len / sizeof(double);
+	return true;
+    }
+
+private:
+    PyArg(const PyArg&);
+    PyArg& operator=(const PyArg&);
+};
+
+// Parameters are recycled over the output.
+static bool recycles(const PyArg& out, const PyArg& par, const char* name)
+{
+    if (par.n == 0 || out.n % par.n != 0) {
+	PyErr_Format(PyExc_ValueError, "the length of %s must divide that of the output.", name);
+	return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Locking //
+//////////////////////////////////////////////////////////////////////
+
+// The GIL is released for the draws, so each object has a lock of its
+// own around its generator.  It is taken with the GIL released, so
+// that a draw already under way on another thread can finish.
+
+#define BEGIN_DRAW(self)				\
+    Py_BEGIN_ALLOW_THREADS				\
+    PyThread_acquire_lock((self)->lock, WAIT_LOCK);
+
+#define END_DRAW(self)					\
+    PyThread_release_lock((self)->lock);		\
+    Py_END_ALLOW_THREADS
+
+static bool make_lock(PyThread_type_lock& lock)
+{
+    if (!lock) lock = PyThread_allocate_lock();
+    if (!lock) {
+	PyErr_NoMemory();
+	return false;
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // RNGPar //
+//////////////////////////////////////////////////////////////////////
+
+struct PyRNGPar {
+    PyObject_HEAD
+    RNGPar<double>*    r;
+    PyThread_type_lock lock;
+};
+
+typedef void (RNGPar<double>::*Par1)(double*, int, double*, int);
+typedef void (RNGPar<double>::*Par2)(double*, int, double*, double*, int);
+
+static int par_init(PyObject* self_, PyObject* args, PyObject* kwds)
+{
+    PyRNGPar* self = (PyRNGPar*)self_;
+    static const char* kw[] = {"nthread", "seed", NULL};
+    int nthread = 1;
+    PyObject* seed = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|iO", (char**)kw, &nthread, &seed))
+	return -1;
+    if (nthread < 1) {
+	PyErr_SetString(PyExc_ValueError, "nthread must be positive.");
+	return -1;
+    }
+
+    unsigned long s = time(NULL);
+    if (seed != Py_None) {
+	s = PyLong_AsUnsignedLong(seed);
+	if (PyErr_Occurred()) return -1;
+    }
+
+    if (!make_lock(self->lock)) return -1;
+
+    BEGIN_DRAW(self)
+    delete self->r;
+    self->r = new RNGPar<double>(nthread, s);
+    END_DRAW(self)
+    return 0;
+}
+
+static void par_dealloc(PyObject* self_)
+{
+    PyRNGPar* self = (PyRNGPar*)self_;
+    delete self->r;
+    if (self->lock) PyThread_free_lock(self->lock);
+    PyTypeObject* tp = Py_TYPE(self_);
+    tp->tp_free(self_);
+    Py_DECREF(tp);
+}
+
+static bool par_ready(PyRNGPar* self, const PyArg& out)
+{
+    if (!self->r) {
+	PyErr_SetString(PyExc_RuntimeError, "RNGPar is not initialized.");
+	return false;
+    }
+    if (out.n > INT_MAX) {
+	PyErr_SetString(PyExc_ValueError, "RNGPar draws at most 2^31 - 1 at a time.");
+	return false;
+    }
+    return true;
+}
+
+static PyObject* par1(PyObject* self_, PyObject* args, Par1 f)
+{
+    PyRNGPar* self = (PyRNGPar*)self_;
+    PyObject *o, *a;
+    if (!PyArg_ParseTuple(args, "OO", &o, &a)) return NULL;
+
+    PyArg out, p1;
+    if (!out.get(o, "out", true) || !p1.get(a, "the parameter")) return NULL;
+    if (!par_ready(self, out) || !recycles(out, p1, "the parameter")) return NULL;
+
+    BEGIN_DRAW(self)
+    (self->r->*f)(out.p, (int)out.n, p1.p, (int)p1.n);
+    END_DRAW(self)
+
+    Py_RETURN_NONE;
+}
+
+// RNGPar recycles both parameters with one length; a lone number is
+// spread to the length of the other, which is all that is copied.
+static PyObject* par2(PyObject* self_, PyObject* args, Par2 f)
+{
+    PyRNGPar* self = (PyRNGPar*)self_;
+    PyObject *o, *a, *b;
+    if (!PyArg_ParseTuple(args, "OOO", &o, &a, &b)) return NULL;
+
+    PyArg out, p1, p2;
+    if (!out.get(o, "out", true) || !p1.get(a, "the first parameter") || !p2.get(b, "the second parameter"))
+	return NULL;
+    if (!par_ready(self, out)
+	|| !recycles(out, p1, "the first parameter")
+	|| !recycles(out, p2, "the second parameter"))
+	return NULL;
+
+    double* q1 = p1.p;
+    double* q2 = p2.p;
+    size_t  np = p1.n > p2.n ? p1.n : p2.n;
+    vector<double> w;
+    if (p1.n != p2.n) {
+	if (p1.n != 1 && p2.n != 1) {
+	    PyErr_SetString(PyExc_ValueError, "the parameters must have the same length, or one length 1.");
+	    return NULL;
+	}
+	w.assign(np, p1.n == 1 ? p1.p[0] : p2.p[0]);
+	if (p1.n == 1) q1 = &w[0]; else q2 = &w[0];
+    }
+
+    BEGIN_DRAW(self)
+    (self->r->*f)(out.p, (int)out.n, q1, q2, (int)np);
+    END_DRAW(self)
+
+    Py_RETURN_NONE;
+}
+
+#define PAR1(NAME) \
+    static PyObject* par_##NAME(PyObject* s, PyObject* a) { return par1(s, a, (Par1)&RNGPar<double>::NAME); }
+#define PAR2(NAME) \
+    static PyObject* par_##NAME(PyObject* s, PyObject* a) { return par2(s, a, (Par2)&RNGPar<double>::NAME); }
+
+PAR1(expon_mean)
+PAR1(expon_rate)
+PAR1(chisq)
+PAR1(poisson)
+PAR2(norm)
+PAR2(gamma_scale)
+PAR2(gamma_rate)
+PAR2(igamma)
+PAR2(flat)
+PAR2(polyagamma)
+PAR2(binom)
+PAR2(negbin)
+
+#undef PAR1
+#undef PAR2
+
+static PyObject* par_size(PyObject* self_, PyObject*)
+{
+    PyRNGPar* self = (PyRNGPar*)self_;
+    return PyLong_FromLong(self->r ? self->r->size() : 0);
+}
+
+static PyObject* par_get_seed(PyObject* self_, PyObject*)
+{
+    PyRNGPar* self = (PyRNGPar*)self_;
+    return PyLong_FromUnsignedLong(self->r ? self->r->get_seed() : 0);
+}
+
+static PyMethodDef par_methods[] = {
+    {"expon_mean" , par_expon_mean , METH_VARARGS, "expon_mean(out, mean)"},
+    {"expon_rate" , par_expon_rate , METH_VARARGS, "expon_rate(out, rate)"},
+    {"chisq"      , par_chisq      , METH_VARARGS, "chisq(out, df)"},
+    {"poisson"    , par_poisson    , METH_VARARGS, "poisson(out, mu)"},
+    {"norm"       , par_norm       , METH_VARARGS, "norm(out, mean, sd)"},
+    {"gamma_scale", par_gamma_scale, METH_VARARGS, "gamma_scale(out, shape, scale)"},
+    {"gamma_rate" , par_gamma_rate , METH_VARARGS, "gamma_rate(out, shape, rate)"},
+    {"igamma"     , par_igamma     , METH_VARARGS, "igamma(out, shape, scale)"},
+    {"flat"       , par_flat       , METH_VARARGS, "flat(out, lower, upper)"},
+    {"polyagamma" , par_polyagamma , METH_VARARGS, "polyagamma(out, b, z)"},
+    {"binom"      , par_binom      , METH_VARARGS, "binom(out, n, p)"},
+    {"negbin"     , par_negbin     , METH_VARARGS, "negbin(out, size, p)"},
+    {"size"       , par_size       , METH_NOARGS , "Number of threads."},
+    {"get_seed"   , par_get_seed   , METH_NOARGS , "Seed of stream 0."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot par_slots[] = {
+    {Py_tp_doc    , (void*)"RNGPar(nthread=1, seed=time) fills buffers of doubles on nthread threads."},
+    {Py_tp_init   , (void*)par_init},
+    {Py_tp_dealloc, (void*)par_dealloc},
+    {Py_tp_methods, (void*)par_methods},
+    {Py_tp_new    , (void*)PyType_GenericNew},
+    {0, NULL}
+};
+
+static PyType_Spec par_spec = {
+    "pyrng.RNGPar", sizeof(PyRNGPar), 0, Py_TPFLAGS_DEFAULT, par_slots
+};
+
+//////////////////////////////////////////////////////////////////////
+			       // RNG //
+//////////////////////////////////////////////////////////////////////
+
+struct PyRNG {
+    PyObject_HEAD
+    RNG*               r;
+    PyThread_type_lock lock;
+};
+
+static int rng_init(PyObject* self_, PyObject* args, PyObject* kwds)
+{
+    PyRNG* self = (PyRNG*)self_;
+    static const char* kw[] = {"seed", NULL};
+    PyObject* seed = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", (char**)kw, &seed))
+	return -1;
+
+    unsigned long s = time(NULL);
+    if (seed != Py_None) {
+	s = PyLong_AsUnsignedLong(seed);
+	if (PyErr_Occurred()) return -1;
+    }
+
+    if (!make_lock(self->lock)) return -1;
+
+    BEGIN_DRAW(self)
+    delete self->r;
+    self->r = new RNG(s);
+    END_DRAW(self)
+    return 0;
+}
+
+static void rng_dealloc(PyObject* self_)
+{
+    PyRNG* self = (PyRNG*)self_;
+    delete self->r;
+    if (self->lock) PyThread_free_lock(self->lock);
+    PyTypeObject* tp = Py_TYPE(self_);
+    tp->tp_free(self_);
+    Py_DECREF(tp);
+}
+
+// Parse out and npar parameters; false with the exception set.
+static bool rng_args(PyRNG* self, PyObject* args, const char* fmt, PyArg& out, PyArg* par, int npar)
+{
+    PyObject* o[5] = {NULL, NULL, NULL, NULL, NULL};
+    if (!PyArg_ParseTuple(args, fmt, &o[0], &o[1], &o[2], &o[3], &o[4])) return false;
+    if (!self->r) {
+	PyErr_SetString(PyExc_RuntimeError, "RNG is not initialized.");
+	return false;
+    }
+    if (!out.get(o[0], "out", true)) return false;
+    for (int k = 0; k < npar; k++)
+	if (!par[k].get(o[k+1], "a parameter") || !recycles(out, par[k], "a parameter"))
+	    return false;
+    return true;
+}
+
+// A scalar parameter needs no RNGSpan, which keeps RNG's hoisting.
+static bool all_scalar(const PyArg* par, int npar)
+{
+    for (int k = 0; k < npar; k++)
+	if (par[k].held) return false;
+    return true;
+}
+
+static PyObject* rng_unif(PyObject* self_, PyObject* args)
+{
+    PyRNG* self = (PyRNG*)self_;
+    PyArg out;
+    if (!rng_args(self, args, "O", out, NULL, 0)) return NULL;
+    RNGSpan X(out.p, out.n);
+    BEGIN_DRAW(self)
+    self->r->unif(X);
+    END_DRAW(self)
+    Py_RETURN_NONE;
+}
+
+#define RNG1(NAME)							\
+    static PyObject* rng_##NAME(PyObject* self_, PyObject* args)	\
+    {									\
+	PyRNG* self = (PyRNG*)self_;					\
+	PyArg out, par[1];						\
+	if (!rng_args(self, args, "OO", out, par, 1)) return NULL;	\
+	RNGSpan X(out.p, out.n), A(par[0].p, par[0].n);			\
+	bool scalar = all_scalar(par, 1);				\
+	BEGIN_DRAW(self)						\
+	if (scalar) self->r->NAME(X, par[0].v);				\
+	else        self->r->NAME(X, A);				\
+	END_DRAW(self)							\
+	Py_RETURN_NONE;							\
+    }									\
+
+#define RNG2(NAME)							\
+    static PyObject* rng_##NAME(PyObject* self_, PyObject* args)	\
+    {									\
+	PyRNG* self = (PyRNG*)self_;					\
+	PyArg out, par[2];						\
+	if (!rng_args(self, args, "OOO", out, par, 2)) return NULL;	\
+	RNGSpan X(out.p, out.n), A(par[0].p, par[0].n), B(par[1].p, par[1].n); \
+	bool scalar = all_scalar(par, 2);				\
+	BEGIN_DRAW(self)						\
+	if (scalar) self->r->NAME(X, par[0].v, par[1].v);		\
+	else        self->r->NAME(X, A, B);				\
+	END_DRAW(self)							\
+	Py_RETURN_NONE;							\
+    }									\
+
+RNG1(expon_mean)
+RNG1(expon_rate)
+RNG1(chisq)
+RNG1(poisson)
+RNG2(norm)
+RNG2(gamma_scale)
+RNG2(gamma_rate)
+RNG2(igamma)
+RNG2(flat)
+RNG2(igauss)
+RNG2(polyagamma)
+
+#undef RNG1
+#undef RNG2
+
+// tnorm(out, left, right, mu, sd), numbers only; right may be inf.
+static PyObject* rng_tnorm(PyObject* self_, PyObject* args)
+{
+    PyRNG* self = (PyRNG*)self_;
+    PyArg out, par[4];
+    if (!rng_args(self, args, "OOOOO", out, par, 4)) return NULL;
+    if (!all_scalar(par, 4)) {
+	PyErr_SetString(PyExc_TypeError, "the tnorm parameters must be numbers.");
+	return NULL;
+    }
+    RNGSpan X(out.p, out.n);
+    BEGIN_DRAW(self)
+    if (par[1].v == HUGE_VAL)
+	self->r->tnorm(X, par[0].v, par[2].v, par[3].v);
+    else
+	self->r->tnorm(X, par[0].v, par[1].v, par[2].v, par[3].v);
+    END_DRAW(self)
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef rng_methods[] = {
+    {"unif"       , rng_unif       , METH_VARARGS, "unif(out)"},
+    {"expon_mean" , rng_expon_mean , METH_VARARGS, "expon_mean(out, mean)"},
+    {"expon_rate" , rng_expon_rate , METH_VARARGS, "expon_rate(out, rate)"},
+    {"chisq"      , rng_chisq      , METH_VARARGS, "chisq(out, df)"},
+    {"poisson"    , rng_poisson    , METH_VARARGS, "poisson(out, mu)"},
+    {"norm"       , rng_norm       , METH_VARARGS, "norm(out, mean, sd)"},
+    {"gamma_scale", rng_gamma_scale, METH_VARARGS, "gamma_scale(out, shape, scale)"},
+    {"gamma_rate" , rng_gamma_rate , METH_VARARGS, "gamma_rate(out, shape, rate)"},
+    {"igamma"     , rng_igamma     , METH_VARARGS, "igamma(out, shape, scale)"},
+    {"flat"       , rng_flat       , METH_VARARGS, "flat(out, lower, upper)"},
+    {"igauss"     , rng_igauss     , METH_VARARGS, "igauss(out, mu, lambda)"},
+    {"polyagamma" , rng_polyagamma , METH_VARARGS, "polyagamma(out, b, z)"},
+    {"tnorm"      , rng_tnorm      , METH_VARARGS, "tnorm(out, left, right, mu, sd)"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyType_Slot rng_slots[] = {
+    {Py_tp_doc    , (void*)"RNG(seed=time) fills buffers of doubles from one stream."},
+    {Py_tp_init   , (void*)rng_init},
+    {Py_tp_dealloc, (void*)rng_dealloc},
+    {Py_tp_methods, (void*)rng_methods},
+    {Py_tp_new    , (void*)PyType_GenericNew},
+    {0, NULL}
+};
+
+static PyType_Spec rng_spec = {
+    "pyrng.RNG", sizeof(PyRNG), 0, Py_TPFLAGS_DEFAULT, rng_slots
+};
+
+//////////////////////////////////////////////////////////////////////
+			      // Module //
+//////////////////////////////////////////////////////////////////////
+
+static PyModuleDef pyrng_module = {
+    PyModuleDef_HEAD_INIT, "pyrng",
+    "In place samplers over buffers of doubles; see RNGPar and RNG.",
+    -1, NULL, NULL, NULL, NULL, NULL
+};
+
+// PyModule_AddObject steals the type only when it succeeds.
+static int add_type(PyObject* m, const char* name, PyType_Spec* spec)
+{
+    PyObject* tp = PyType_FromSpec(spec);
+    if (!tp) return -1;
+    if (PyModule_AddObject(m, name, tp) < 0) {
+	Py_DECREF(tp);
+	return -1;
+    }
+    return 0;
+}
+
+PyMODINIT_FUNC PyInit_pyrng(void)
+{
+    PyObject* m = PyModule_Create(&pyrng_module);
+    if (!m) return NULL;
+
+    if (add_type(m, "RNGPar", &par_spec) < 0 || add_type(m, "RNG", &rng_spec) < 0) {
+	Py_DECREF(m);
+	return NULL;
+    }
+
+    return m;
+}
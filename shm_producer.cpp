@@ -0,0 +1,218 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+/*********************************************************************
+
+  Producer for ShmRNG; see ShmRNG.hpp.
+
+    shm_producer [-n name] [-s slots] [-c capacity] [-S seed]
+
+  Creates the shared memory segment, keeps every ring full until it
+  gets SIGINT or SIGTERM, and then removes the segment.  Clients that
+  are still running notice and draw locally.  They also notice if the
+  producer dies without removing the segment, and the next producer
+  removes it.
+
+*********************************************************************/
+
+#include "ShmRNG.hpp"
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+#include <cstdio>
+#include <cmath>
+
+// The producer naps while every ring is full, for SHM_NAP_MIN
+// microseconds at first and twice as long each time after, up to
+// SHM_NAP_MAX.  A condition variable in the segment would let clients
+// wake it, but a client killed while holding its mutex would hang the
+// producer.
+#define SHM_NAP_MIN 20
+#define SHM_NAP_MAX 1000
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int)
+{
+    stop = 1;
+}
+
+static void generate(gsl_rng* gen, int kind, double* x, unsigned int n)
+{
+    unsigned int i;
+    switch (kind) {
+    case SHM_NORM:
+	for (i = 0; i < n; i++) x[i] = gsl_ran_gaussian_ziggurat(gen, 1.0);
+	break;
+    case SHM_EXPON:
+	for (i = 0; i < n; i++) x[i] = -log(gsl_rng_uniform_pos(gen));
+	break;
+    default:
+	for (i = 0; i < n; i++) x[i] = gsl_rng_uniform_pos(gen);
+    }
+}
+
+// Fill one chunk of empty places of one ring and publish it.  Return
+// whether there was any room.
+
+static bool fill(ShmHeader* hdr, uint32_t s, int kind, gsl_rng* gen)
+{
+    ShmRing& R = shm_slot(hdr, s)->ring[kind];
+    uint32_t at;
+    uint32_t room = ring_room(R, hdr->capacity, at);
+    if (room == 0) return false;
+
+    generate(gen, kind, shm_buffer(hdr, s, kind) + at, room);
+    ring_push(R, room);
+    return true;
+}
+
+static void nap(long usec)
+{
+    struct timespec ts;
+    ts.tv_sec  = 0;
+    ts.tv_nsec = usec * 1000;
+    nanosleep(&ts, NULL);
+}
+
+// Remove the segment name if a producer left it behind when it died.
+// Return whether it did.
+
+static bool unlink_stale(const char* name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    bool  stale = false;
+    void* p     = mmap(NULL, sizeof(ShmHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p != MAP_FAILED) {
+	ShmHeader* hdr = (ShmHeader*)p;
+	int32_t    pid = hdr->producer;
+	stale = hdr->magic == SHM_MAGIC && pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+	munmap(p, sizeof(ShmHeader));
+    }
+
+    if (stale) {
+	fprintf(stderr, "shm_producer: removing %s, left by a producer that died.\n", name);
+	shm_unlink(name);
+    }
+    return stale;
+}
+
+int main(int argc, char** argv)
+{
+    const char*   name     = SHM_DEFAULT_NAME;
+    uint32_t      nslots   = 16;
+    uint32_t      capacity = 65536;
+    unsigned long seed     = time(NULL);
+
+    int c;
+    while ((c = getopt(argc, argv, "n:s:c:S:")) != -1) {
+	switch (c) {
+	case 'n': name     = optarg; break;
+	case 's': nslots   = strtoul(optarg, NULL, 10); break;
+	case 'c': capacity = strtoul(optarg, NULL, 10); break;
+	case 'S': seed     = strtoul(optarg, NULL, 10); break;
+	default:
+	    fprintf(stderr, "usage: %s [-n name] [-s slots] [-c capacity] [-S seed]\n", argv[0]);
+	    return 1;
+	}
+    }
+
+    uint32_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    if (nslots < 1) nslots = 1;
+
+    size_t bytes = shm_size(nslots, cap);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST && unlink_stale(name))
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+	fprintf(stderr, "shm_producer: could not create %s; is a producer running?\n", name);
+	return 1;
+    }
+    if (ftruncate(fd, bytes) != 0) {
+	fprintf(stderr, "shm_producer: could not size %s to %lu bytes.\n", name, (unsigned long)bytes);
+	shm_unlink(name);
+	return 1;
+    }
+
+    void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+	fprintf(stderr, "shm_producer: could not map %s.\n", name);
+	shm_unlink(name);
+	return 1;
+    }
+
+    // ftruncate zeroed the slots.
+    ShmHeader* hdr = (ShmHeader*)p;
+    hdr->magic    = SHM_MAGIC;
+    hdr->version  = SHM_VERSION;
+    hdr->nslots   = nslots;
+    hdr->capacity = cap;
+    hdr->seed     = seed;
+    hdr->producer = (int32_t)getpid();
+
+    // One stream per kind, dealt out to the slots a chunk at a time.
+    gsl_rng* seeder = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(seeder, seed);
+    gsl_rng* gen[SHM_NKIND];
+    for (int k = 0; k < SHM_NKIND; k++) {
+	gen[k] = gsl_rng_alloc(gsl_rng_mt19937);
+	gsl_rng_set(gen[k], gsl_rng_get(seeder));
+    }
+    gsl_rng_free(seeder);
+
+    signal(SIGINT , on_signal);
+    signal(SIGTERM, on_signal);
+
+    __sync_synchronize();
+    hdr->alive = 1;
+
+    long wait = SHM_NAP_MIN;
+    while (!stop) {
+	bool busy = false;
+	for (uint32_t s = 0; s < nslots; s++)
+	    for (int k = 0; k < SHM_NKIND; k++)
+		busy = fill(hdr, s, k, gen[k]) || busy;
+	if (busy)
+	    wait = SHM_NAP_MIN;
+	else {
+	    nap(wait);
+	    if (wait < SHM_NAP_MAX) wait *= 2;
+	}
+	__sync_synchronize();
+    }
+
+    hdr->alive = 0;
+    __sync_synchronize();
+
+    for (int k = 0; k < SHM_NKIND; k++)
+	gsl_rng_free(gen[k]);
+    munmap(p, bytes);
+    shm_unlink(name);
+
+    return 0;
+}
@@ -35,6 +35,18 @@ int main(int argc, char** argv)
   r.tnorm(samp, 1.0, 1.0, 0.0, 1.0);
   samp.dump("tnorm.txt", false);
 
+  // Inverse Gaussian
+  r.igauss(samp, 2.0, 3.0);
+  samp.dump("igauss.txt", false);
+
+  // Generalized inverse Gaussian
+  r.gig(samp, 0.5, 1.0, 2.0);
+  samp.dump("gig.txt", false);
+
+  // Polya-Gamma
+  r.polyagamma(samp, 1.0, 2.0);
+  samp.dump("pg.txt", false);
+
   cout << RNG::p_norm(-1.96) << " " << RNG::p_norm(0.0) << "\n";
 
   r.unif(samp);
@@ -0,0 +1,851 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+// Statistical equivalence of the samplers, for checking a fast path
+// against the reference before it is merged.
+//
+//   test_equiv [-n draws] [-s seed] [-a alpha]
+//
+// Every sampler is drawn through each path -- scalar RNG calls, the
+// Matrix fillers, RNGPar on OpenMP, BufferedRNG, and the TapeRNG (live),
+// PhiloxRNG, and scrambled SobolRNG engines -- and through GSL's own
+// sampler where there is one.  PhiloxStreams runs unif, norm, and
+// expon, its only samplers, across BLOCK streams.  On Sobol points only
+// the samplers that invert a CDF with one uniform are run.  Dirichlet and multinomial are
+// checked through one component, whose marginal is beta or binomial;
+// gig and polyagamma, which have no CDF here, through their moments
+// only.
+//
+// Draws stream through EquivStat and are never stored.  With the exact
+// CDF F each draw is binned by F(x), which gives Kolmogorov-Smirnov,
+// Anderson-Darling, and a chi-square against the exact distribution;
+// discrete draws use the randomized F(x-1) + V (F(x) - F(x-1)).  The
+// mean and variance are compared with their known values and every
+// path with the GSL reference by two sample Kolmogorov-Smirnov and
+// chi-square.
+//
+// BufferedRNG is also checked against itself with background=false,
+// which must give the same draws.
+//
+// A line is marked when any of its p-values falls below alpha.  With
+// a few hundred tests at alpha = 1e-4 a false mark is rare; if one
+// shows up, rerun with another seed.  Exits 1 if anything was marked.
+
+#include "Matrix.h"
+#include "RNG.hpp"
+#include "CPURNG.hpp"
+#include "BufferedRNG.hpp"
+#include "TapeEngine.hpp"
+#include "PhiloxEngine.hpp"
+#include "SobolEngine.hpp"
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_cdf.h>
+#include <gsl/gsl_sf_bessel.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+//////////////////////////////////////////////////////////////////////
+			   // Statistics //
+//////////////////////////////////////////////////////////////////////
+
+// Kolmogorov's limiting P(sqrt(n) D > lambda).
+double q_ks(double lambda)
+{
+  if (lambda < 0.2) return 1.0;
+  double sum = 0.0, sign = 1.0;
+  for (int k = 1; k <= 100; k++) {
+    double term = 2.0 * sign * exp(-2.0 * k * k * lambda * lambda);
+    sum  += term;
+    sign  = -sign;
+    if (fabs(term) < 1e-12) break;
+  }
+  return sum < 0 ? 0 : (sum > 1 ? 1 : sum);
+}
+
+// Marsaglia and Marsaglia, Evaluating the Anderson-Darling
+// distribution (2004): P(A^2 < z), n large.
+double p_ad(double z)
+{
+  if (z <= 0) return 0.0;
+  if (z < 2.0)
+    return exp(-1.2337141 / z) / sqrt(z)
+      * (2.00012 + (.247105 - (.0649821 - (.0347962 - (.011672 - .00168691 * z) * z) * z) * z) * z);
+  return exp(-exp(1.0776 - (2.30695 - (.43424 - (.082433 - (.008056 - .0003146 * z) * z) * z) * z) * z));
+}
+
+double q_chisq(double x, double df)
+{
+  return 1.0 - RNGMath::p_gamma(0.5 * x, 0.5 * df, RNGMath::lgamma(0.5 * df));
+}
+
+double q_z(double z) { return 2.0 * RNGMath::p_norm(-fabs(z)); }
+
+class EquivStat {
+
+ public:
+
+  enum {NBIN = 4096, NCOARSE = 64};
+
+  double n;
+  vector<double> hist;          // Counts of F(x), if binned.
+  double mean, M2, M3, M4;      // Central sums, updated online.
+
+  EquivStat() : n(0), hist(NBIN, 0.0), mean(0), M2(0), M3(0), M4(0) {}
+
+  // u = F(x), or negative if there is no CDF.
+  void add(double x, double u)
+  {
+    double n1 = n;
+    n += 1;
+    double d  = x - mean;
+    double dn = d / n;
+    double t  = d * dn * n1;
+    mean += dn;
+    M4 += t * dn * dn * (n * n - 3 * n + 3) + 6 * dn * dn * M2 - 4 * dn * M3;
+    M3 += t * dn * (n - 2) - 3 * dn * M2;
+    M2 += t;
+
+    if (u >= 0) {
+      int j = (int)(u * NBIN);
+      hist[j < NBIN ? j : NBIN - 1] += 1;
+    }
+  }
+
+  double var() const { return M2 / (n - 1); }
+
+  // Against U(0, 1).
+  double ks() const
+  {
+    double c = 0, D = 0;
+    for (int j = 0; j < NBIN; j++) {
+      c += hist[j];
+      D = std::max(D, fabs(c / n - (j + 1.0) / NBIN));
+    }
+    double sn = sqrt(n);
+    return q_ks((sn + 0.12 + 0.11 / sn) * D);
+  }
+
+  // Grouped Anderson-Darling, Choulakian, Lockhart, and Stephens (1994).
+  double ad() const
+  {
+    double c = 0, A = 0;
+    for (int j = 0; j < NBIN - 1; j++) {
+      c += hist[j];
+      double H = (j + 1.0) / NBIN;
+      double Z = c / n - H;
+      A += Z * Z / (H * (1 - H)) / NBIN;
+    }
+    return 1.0 - p_ad(n * A);
+  }
+
+  double chisq() const
+  {
+    double E = n / NCOARSE, X = 0;
+    for (int k = 0; k < NCOARSE; k++) {
+      double O = 0;
+      for (int j = 0; j < NBIN / NCOARSE; j++) O += hist[k * (NBIN / NCOARSE) + j];
+      X += (O - E) * (O - E) / E;
+    }
+    return q_chisq(X, NCOARSE - 1);
+  }
+
+  double mean_test(double mu) const { return q_z((mean - mu) / sqrt(var() / n)); }
+
+  double var_test(double sig2) const
+  {
+    double m4 = M4 / n, s2 = M2 / n;
+    return q_z((var() - sig2) / sqrt((m4 - s2 * s2) / n));
+  }
+
+  // Two sample, against the reference.
+  double ks(const EquivStat& ref) const
+  {
+    double c = 0, d = 0, D = 0;
+    for (int j = 0; j < NBIN; j++) {
+      c += hist[j];
+      d += ref.hist[j];
+      D = std::max(D, fabs(c / n - d / ref.n));
+    }
+    return q_ks(sqrt(n * ref.n / (n + ref.n)) * D);
+  }
+
+  double chisq(const EquivStat& ref) const
+  {
+    double a = sqrt(ref.n / n), b = sqrt(n / ref.n), X = 0;
+    int df = -1;
+    for (int k = 0; k < NCOARSE; k++) {
+      double O1 = 0, O2 = 0;
+      for (int j = 0; j < NBIN / NCOARSE; j++) {
+	O1 += hist[k * (NBIN / NCOARSE) + j];
+	O2 += ref.hist[k * (NBIN / NCOARSE) + j];
+      }
+      if (O1 + O2 == 0) continue;
+      X += (a * O1 - b * O2) * (a * O1 - b * O2) / (O1 + O2);
+      df++;
+    }
+    return q_chisq(X, df);
+  }
+
+};
+
+//////////////////////////////////////////////////////////////////////
+			    // Samplers //
+//////////////////////////////////////////////////////////////////////
+
+enum Kind {FLAT, EXPON, NORM, GAMMA, IGAMMA, CHISQ, TNORM1, TNORM2, RTGAMMA, IGAUSS, POISSON, PG,
+	   GIG, BETA, BINOM, NEGBIN, BERN, BERN_MASK, CATEG, CATEG_LOG, DIRICHLET, MULTINOM};
+
+// Weights for categorical, one of them zero; alpha for dirichlet, whose
+// first component takes the alpha < 1 branch; p for multinomial, which
+// is checked through its second count.
+const int    NCAT = 4;
+const double CAT_W[NCAT] = {0.1, 0.0, 0.6, 0.3};
+const int    NDIR = 3;
+const double DIR_A[NDIR] = {0.4, 1.5, 2.0};
+const int    NMULT = 3;
+const double MULT_P[NMULT] = {0.2, 0.5, 0.3};
+
+struct Spec {
+  const char* name;
+  int kind;
+  double a, b, c;
+};
+
+// Each tnorm and rtgamma line is aimed at one of the kernels.
+const Spec specs[] = {
+  {"flat(-1, 3)",          FLAT,    -1.0,  3.0, 0},
+  {"expon_rate(1.7)",      EXPON,    1.7,  0,   0},
+  {"norm(1, 2)",           NORM,     1.0,  2.0, 0},
+  {"gamma_rate(0.5, 2)",   GAMMA,    0.5,  2.0, 0},
+  {"gamma_rate(4.2, 2)",   GAMMA,    4.2,  2.0, 0},
+  {"igamma(6, 3)",         IGAMMA,   6.0,  3.0, 0},
+  {"chisq(3)",             CHISQ,    3.0,  0,   0},
+  {"tnorm(-0.5)",          TNORM1,  -0.5,  0,   0},
+  {"tnorm(2.5)",           TNORM1,   2.5,  0,   0},
+  {"tnorm(-1, 1)",         TNORM2,  -1.0,  1.0, 0},
+  {"tnorm(1, 1.3)",        TNORM2,   1.0,  1.3, 0},
+  {"tnorm(2, 6)",          TNORM2,   2.0,  6.0, 0},
+  {"tnorm(-3, -2.5)",      TNORM2,  -3.0, -2.5, 0},
+  {"rtgamma(0.5, 0.2, 1)", RTGAMMA,  0.5,  0.2, 1.0},
+  {"rtgamma(2, 3, 1)",     RTGAMMA,  2.0,  3.0, 1.0},
+  {"rtgamma(1, 8, 1)",     RTGAMMA,  1.0,  8.0, 1.0},
+  {"igauss(2, 3)",         IGAUSS,   2.0,  3.0, 0},
+  {"poisson(3.5)",         POISSON,  3.5,  0,   0},
+  {"poisson(40)",          POISSON, 40.0,  0,   0},
+  {"polyagamma(1, 2)",     PG,       1.0,  2.0, 0},
+  {"polyagamma(20, 1)",    PG,      20.0,  1.0, 0},
+  {"polyagamma(200, 1)",   PG,     200.0,  1.0, 0},
+  {"gig(0.5, 2, 3)",       GIG,      0.5,  2.0, 3.0},
+  {"gig(3, 1, 1)",         GIG,      3.0,  1.0, 1.0},
+  {"gig(0.2, .01, .01)",   GIG,      0.2,  0.01, 0.01},
+  {"beta(0.5, 0.7)",       BETA,     0.5,  0.7, 0},
+  {"beta(3, 2)",           BETA,     3.0,  2.0, 0},
+  {"binom(8, 0.3)",        BINOM,    8.0,  0.3, 0},
+  {"binom(200, 0.4)",      BINOM,  200.0,  0.4, 0},
+  {"negbin(3, 0.4)",       NEGBIN,   3.0,  0.4, 0},
+  {"bern(0.3)",            BERN,     0.3,  0,   0},
+  {"bern_mask(0.3)",       BERN_MASK,0.3,  0,   0},
+  {"categorical(w)",       CATEG,    0,    0,   0},
+  {"categorical_log(w)",   CATEG_LOG,0,    0,   0},
+  {"dirichlet(alpha)[0]",  DIRICHLET,0,    0,   0},
+  {"multinomial(20, p)[1]",MULTINOM, 20.0, 0,   0}
+};
+
+const int NSPEC = sizeof(specs) / sizeof(Spec);
+
+double dir_sum()
+{
+  double A = 0;
+  for (int k = 0; k < NDIR; k++) A += DIR_A[k];
+  return A;
+}
+
+// P(X <= x), or -1 if there is none.
+double cdf(const Spec& s, double x)
+{
+  switch (s.kind) {
+  case FLAT   : return x < s.a ? 0 : (x > s.b ? 1 : (x - s.a) / (s.b - s.a));
+  case EXPON  : return x < 0 ? 0 : -expm1(-s.a * x);
+  case NORM   : return RNG::p_norm((x - s.a) / s.b);
+  case GAMMA  : return x < 0 ? 0 : RNG::p_gamma_rate(x, s.a, s.b);
+  case IGAMMA : return x <= 0 ? 0 : 1.0 - RNG::p_gamma_rate(1.0 / x, s.a, s.b);
+  case CHISQ  : return x < 0 ? 0 : RNG::p_gamma_rate(x, 0.5 * s.a, 0.5);
+  case TNORM1 :
+    if (x < s.a) return 0;
+    return 1.0 - RNG::p_norm(-x) / RNG::p_norm(-s.a);
+  case TNORM2 : {
+    if (x < s.a) return 0;
+    if (x > s.b) return 1;
+    if (s.a >= 0) {
+      double Pa = RNG::p_norm(-s.a), Pb = RNG::p_norm(-s.b);
+      return (Pa - RNG::p_norm(-x)) / (Pa - Pb);
+    }
+    double Pa = RNG::p_norm(s.a), Pb = RNG::p_norm(s.b);
+    return (RNG::p_norm(x) - Pa) / (Pb - Pa);
+  }
+  case RTGAMMA:
+    if (x < 0) return 0;
+    if (x > s.c) return 1;
+    return RNG::p_gamma_rate(x, s.a, s.b) / RNG::p_gamma_rate(s.c, s.a, s.b);
+  case IGAUSS : return x <= 0 ? 0 : RNG::p_igauss(x, s.a, s.b);
+  case POISSON:
+    if (x < 0) return 0;
+    return 1.0 - RNGMath::p_gamma(s.a, floor(x) + 1, RNGMath::lgamma(floor(x) + 1));
+  case BETA   : return x <= 0 ? 0 : (x >= 1 ? 1 : gsl_cdf_beta_P(x, s.a, s.b));
+  case BINOM  : return x < 0 ? 0 : gsl_cdf_binomial_P((unsigned int)x, s.b, (unsigned int)s.a);
+  case NEGBIN : return x < 0 ? 0 : gsl_cdf_negative_binomial_P((unsigned int)x, s.b, s.a);
+  case BERN   :
+  case BERN_MASK: return x < 0 ? 0 : (x < 1 ? 1 - s.a : 1);
+  case CATEG  :
+  case CATEG_LOG: {
+    double c = 0, t = 0;
+    for (int k = 0; k < NCAT; k++) {
+      t += CAT_W[k];
+      if (k <= x) c += CAT_W[k];
+    }
+    return c / t;
+  }
+  case DIRICHLET:
+    return x <= 0 ? 0 : (x >= 1 ? 1 : gsl_cdf_beta_P(x, DIR_A[0], dir_sum() - DIR_A[0]));
+  case MULTINOM:
+    return x < 0 ? 0 : gsl_cdf_binomial_P((unsigned int)x, MULT_P[1], (unsigned int)s.a);
+  default     : return -1;
+  }
+}
+
+bool discrete(const Spec& s)
+{
+  switch (s.kind) {
+  case POISSON: case BINOM: case NEGBIN: case BERN: case BERN_MASK:
+  case CATEG: case CATEG_LOG: case MULTINOM:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Mean and variance, where the test of the variance makes sense.
+bool moments(const Spec& s, double& mu, double& var)
+{
+  switch (s.kind) {
+  case FLAT   : mu = 0.5 * (s.a + s.b); var = (s.b - s.a) * (s.b - s.a) / 12; return true;
+  case EXPON  : mu = 1.0 / s.a; var = mu * mu; return true;
+  case NORM   : mu = s.a; var = s.b * s.b; return true;
+  case GAMMA  : mu = s.a / s.b; var = mu / s.b; return true;
+  case IGAMMA : mu = s.b / (s.a - 1); var = mu * mu / (s.a - 2); return true;
+  case CHISQ  : mu = s.a; var = 2 * s.a; return true;
+  case IGAUSS : mu = s.a; var = s.a * s.a * s.a / s.b; return true;
+  case POISSON: mu = s.a; var = s.a; return true;
+  case PG     :
+    mu  = s.a / (2 * s.b) * tanh(0.5 * s.b);
+    var = s.a / (4 * s.b * s.b * s.b) * (sinh(s.b) - s.b) / (cosh(0.5 * s.b) * cosh(0.5 * s.b));
+    return true;
+  case GIG    : {
+    // E X^k = (chi / psi)^(k/2) K_{lambda+k}(omega) / K_lambda(omega).
+    double w  = sqrt(s.b * s.c), r = sqrt(s.b / s.c);
+    double K0 = gsl_sf_bessel_Knu(fabs(s.a), w);
+    double m2 = r * r * gsl_sf_bessel_Knu(fabs(s.a + 2), w) / K0;
+    mu  = r * gsl_sf_bessel_Knu(fabs(s.a + 1), w) / K0;
+    var = m2 - mu * mu;
+    return true;
+  }
+  case BETA   :
+    mu  = s.a / (s.a + s.b);
+    var = mu * (1 - mu) / (s.a + s.b + 1);
+    return true;
+  case BINOM  : mu = s.a * s.b; var = mu * (1 - s.b); return true;
+  case NEGBIN : mu = s.a * (1 - s.b) / s.b; var = mu / s.b; return true;
+  case BERN   :
+  case BERN_MASK: mu = s.a; var = s.a * (1 - s.a); return true;
+  case CATEG  :
+  case CATEG_LOG: {
+    double t = 0, m1 = 0, m2 = 0;
+    for (int k = 0; k < NCAT; k++) {
+      t  += CAT_W[k];
+      m1 += k * CAT_W[k];
+      m2 += k * k * CAT_W[k];
+    }
+    mu  = m1 / t;
+    var = m2 / t - mu * mu;
+    return true;
+  }
+  case DIRICHLET: {
+    double A = dir_sum();
+    mu  = DIR_A[0] / A;
+    var = mu * (1 - mu) / (A + 1);
+    return true;
+  }
+  case MULTINOM: mu = s.a * MULT_P[1]; var = mu * (1 - MULT_P[1]); return true;
+  default     : return false;
+  }
+}
+
+double cat_lw(int k) { return CAT_W[k] > 0 ? log(CAT_W[k]) - 700.0 : -HUGE_VAL; }
+
+template<typename R>
+double draw(R& r, const Spec& s)
+{
+  switch (s.kind) {
+  case FLAT   : return r.flat(s.a, s.b);
+  case EXPON  : return r.expon_rate(s.a);
+  case NORM   : return r.norm(s.a, s.b);
+  case GAMMA  : return r.gamma_rate(s.a, s.b);
+  case IGAMMA : return r.igamma(s.a, s.b);
+  case CHISQ  : return r.chisq(s.a);
+  case TNORM1 : return r.tnorm(s.a);
+  case TNORM2 : return r.tnorm(s.a, s.b);
+  case RTGAMMA: return r.rtgamma_rate(s.a, s.b, s.c);
+  case IGAUSS : return r.igauss(s.a, s.b);
+  case POISSON: return r.poisson(s.a);
+  case GIG    : return r.gig(s.a, s.b, s.c);
+  case BETA   : return r.beta(s.a, s.b);
+  case BINOM  : return r.binom((int)s.a, s.b);
+  case NEGBIN : return r.negbin(s.a, s.b);
+  case BERN   : return r.bern(s.a);
+  case BERN_MASK: {
+    // The form with a probability per draw, one draw at a time.
+    uint32_t m;
+    double   p = s.a;
+    r.bern_mask(&m, 1, &p);
+    return m;
+  }
+  case CATEG  : return r.categorical(CAT_W, NCAT);
+  case CATEG_LOG: {
+    // Log weights far below 0, as from a likelihood.
+    double lw[NCAT];
+    for (int k = 0; k < NCAT; k++) lw[k] = cat_lw(k);
+    return r.categorical_log(lw, NCAT);
+  }
+  case DIRICHLET: {
+    double x[NDIR];
+    r.dirichlet(x, DIR_A, NDIR);
+    return x[0];
+  }
+  case MULTINOM: {
+    int c[NMULT];
+    r.multinomial(c, (int)s.a, MULT_P, NMULT);
+    return c[1];
+  }
+  default     : return r.polyagamma(s.a, s.b);
+  }
+}
+
+// Component j of the K-vectors in X, into the n elements of M.
+void component(Matrix& M, const Matrix& X, int K, int j)
+{
+  int n = M.size();
+  for (int i = 0; i < n; i++) M(i) = X(i * K + j);
+}
+
+// The Matrix fillers.  False if there is none.
+template<typename R>
+bool fill(R& r, Matrix& M, const Spec& s)
+{
+  switch (s.kind) {
+  case FLAT   : r.flat(M, s.a, s.b); return true;
+  case EXPON  : r.expon_rate(M, s.a); return true;
+  case NORM   : r.norm(M, s.a, s.b); return true;
+  case GAMMA  : r.gamma_rate(M, s.a, s.b); return true;
+  case IGAMMA : r.igamma(M, s.a, s.b); return true;
+  case CHISQ  : r.chisq(M, s.a); return true;
+  case TNORM1 : r.tnorm(M, s.a, 0.0, 1.0); return true;
+  case TNORM2 : r.tnorm(M, s.a, s.b, 0.0, 1.0); return true;
+  case IGAUSS : r.igauss(M, s.a, s.b); return true;
+  case POISSON: r.poisson(M, s.a); return true;
+  case PG     : r.polyagamma(M, s.a, s.b); return true;
+  case GIG    : r.gig(M, s.a, s.b, s.c); return true;
+  case BINOM  : r.binom(M, (int)s.a, s.b); return true;
+  case NEGBIN : r.negbin(M, s.a, s.b); return true;
+  case BERN   : r.bern(M, s.a); return true;
+  case BERN_MASK: {
+    int n = M.size();
+    vector<uint32_t> m((n + 31) / 32);
+    r.bern_mask(&m[0], n, s.a);
+    for (int i = 0; i < n; i++) M(i) = (m[i / 32] >> (i % 32)) & 1;
+    return true;
+  }
+  case CATEG  : {
+    AliasTable tab(CAT_W, NCAT);
+    r.categorical(M, tab);
+    return true;
+  }
+  case CATEG_LOG: {
+    Matrix lw(NCAT);
+    for (int k = 0; k < NCAT; k++) lw(k) = cat_lw(k);
+    r.categorical_log(M, lw);
+    return true;
+  }
+  case DIRICHLET: {
+    Matrix X(M.size() * NDIR), A(NDIR);
+    for (int k = 0; k < NDIR; k++) A(k) = DIR_A[k];
+    r.dirichlet(X, A);
+    component(M, X, NDIR, 0);
+    return true;
+  }
+  case MULTINOM: {
+    Matrix X(M.size() * NMULT), P(NMULT);
+    for (int k = 0; k < NMULT; k++) P(k) = MULT_P[k];
+    r.multinomial(X, (int)s.a, P);
+    component(M, X, NMULT, 1);
+    return true;
+  }
+  default     : return false;
+  }
+}
+
+bool fill(RNGPar<double>& r, double* x, int n, const Spec& s)
+{
+  double a = s.a, b = s.b;
+  switch (s.kind) {
+  case FLAT   : r.flat(x, n, &a, &b, 1); return true;
+  case EXPON  : r.expon_rate(x, n, &a, 1); return true;
+  case NORM   : r.norm(x, n, &a, &b, 1); return true;
+  case GAMMA  : r.gamma_rate(x, n, &a, &b, 1); return true;
+  case IGAMMA : r.igamma(x, n, &a, &b, 1); return true;
+  case CHISQ  : r.chisq(x, n, &a, 1); return true;
+  case POISSON: r.poisson(x, n, &a, 1); return true;
+  case PG     : r.polyagamma(x, n, &a, &b, 1); return true;
+  case BINOM  : r.binom(x, n, &a, &b, 1); return true;
+  case NEGBIN : r.negbin(x, n, &a, &b, 1); return true;
+  case CATEG  : {
+    double w[NCAT];
+    for (int k = 0; k < NCAT; k++) w[k] = CAT_W[k];
+    r.categorical(x, n, w, NCAT);
+    return true;
+  }
+  case CATEG_LOG: {
+    double lw[NCAT];
+    for (int k = 0; k < NCAT; k++) lw[k] = cat_lw(k);
+    r.categorical_log(x, n, lw, NCAT);
+    return true;
+  }
+  case DIRICHLET: {
+    double al[NDIR];
+    for (int k = 0; k < NDIR; k++) al[k] = DIR_A[k];
+    vector<double> X(n * NDIR);
+    r.dirichlet(&X[0], n, al, NDIR);
+    for (int i = 0; i < n; i++) x[i] = X[i * NDIR];
+    return true;
+  }
+  case MULTINOM: {
+    double p[NMULT];
+    for (int k = 0; k < NMULT; k++) p[k] = MULT_P[k];
+    vector<double> X(n * NMULT);
+    r.multinomial(&X[0], n, (int)s.a, p, NMULT);
+    for (int i = 0; i < n; i++) x[i] = X[i * NMULT + 1];
+    return true;
+  }
+  default     : return false;
+  }
+}
+
+// GSL's sampler, or inversion where GSL has none.  False if neither.
+bool reference(gsl_rng* g, const Spec& s, double& x)
+{
+  switch (s.kind) {
+  case FLAT   : x = gsl_ran_flat(g, s.a, s.b); return true;
+  case EXPON  : x = gsl_ran_exponential(g, 1.0 / s.a); return true;
+  case NORM   : x = s.a + gsl_ran_gaussian(g, s.b); return true;
+  case GAMMA  : x = gsl_ran_gamma(g, s.a, 1.0 / s.b); return true;
+  case IGAMMA : x = 1.0 / gsl_ran_gamma(g, s.a, 1.0 / s.b); return true;
+  case CHISQ  : x = gsl_ran_chisq(g, s.a); return true;
+  case POISSON: x = gsl_ran_poisson(g, s.a); return true;
+  case TNORM1 :
+  case TNORM2 : {
+    // Invert in the upper tail, where the CDF keeps its precision.
+    double l = s.a, r = s.kind == TNORM1 ? HUGE_VAL : s.b;
+    double sign = 1.0;
+    if (l < 0 && r <= 0) { double t = l; l = -r; r = -t; sign = -1.0; }
+    double Pl = RNG::p_norm(-l), Pr = RNG::p_norm(-r);
+    x = -sign * RNGMath::q_norm(Pr + (Pl - Pr) * gsl_rng_uniform_pos(g));
+    return true;
+  }
+  case RTGAMMA:
+    do x = gsl_ran_gamma(g, s.a, 1.0 / s.b); while (x > s.c);
+    return true;
+  case BETA   : x = gsl_ran_beta(g, s.a, s.b); return true;
+  case BINOM  : x = gsl_ran_binomial(g, s.b, (unsigned int)s.a); return true;
+  case NEGBIN : x = gsl_ran_negative_binomial(g, s.b, s.a); return true;
+  case BERN   :
+  case BERN_MASK: x = gsl_ran_bernoulli(g, s.a); return true;
+  case CATEG  :
+  case CATEG_LOG: {
+    static gsl_ran_discrete_t* tab = gsl_ran_discrete_preproc(NCAT, CAT_W);
+    x = gsl_ran_discrete(g, tab);
+    return true;
+  }
+  case DIRICHLET: {
+    double th[NDIR];
+    gsl_ran_dirichlet(g, NDIR, DIR_A, th);
+    x = th[0];
+    return true;
+  }
+  case MULTINOM: {
+    unsigned int c[NMULT];
+    gsl_ran_multinomial(g, NMULT, (unsigned int)s.a, MULT_P, c);
+    x = c[1];
+    return true;
+  }
+  default     : return false;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Paths //
+//////////////////////////////////////////////////////////////////////
+
+const int BLOCK = 4096;
+
+struct Path {
+  const char* name;
+  Path(const char* name_) : name(name_) {}
+  virtual ~Path() {}
+  virtual bool fill(const Spec& s, double* x, int n) = 0;
+};
+
+template<typename R>
+struct ScalarPath : public Path {
+  R& r;
+  ScalarPath(const char* name_, R& r_) : Path(name_), r(r_) {}
+  bool fill(const Spec& s, double* x, int n)
+  {
+    for (int i = 0; i < n; i++) x[i] = draw(r, s);
+    return true;
+  }
+};
+
+// Samplers that invert a CDF with one uniform, the only ones that are
+// valid on Sobol points; see SobolEngine.hpp.
+bool inverts(const Spec& s)
+{
+  switch (s.kind) {
+  case FLAT: case EXPON: case NORM: case BERN: case CATEG: case CATEG_LOG:
+    return true;
+  default:
+    return false;
+  }
+}
+
+struct SobolPath : public ScalarPath<SobolRNG> {
+  SobolPath(SobolRNG& r_) : ScalarPath<SobolRNG>("sobol", r_) {}
+  bool fill(const Spec& s, double* x, int n)
+  {
+    return inverts(s) && ScalarPath<SobolRNG>::fill(s, x, n);
+  }
+};
+
+// PhiloxStreams, which has only unif, norm, and expon.  Each call
+// advances every stream by one block and x takes the first n streams.
+struct StreamsPath : public Path {
+  PhiloxStreams& ps;
+  vector<double> y;
+  StreamsPath(PhiloxStreams& ps_) : Path("streams"), ps(ps_), y(ps_.size()) {}
+  bool fill(const Spec& s, double* x, int n)
+  {
+    switch (s.kind) {
+    case FLAT:
+      ps.unif(&y[0]);
+      for (int i = 0; i < n; i++) x[i] = s.a + (s.b - s.a) * y[i];
+      return true;
+    case EXPON:
+      ps.expon(&y[0]);
+      for (int i = 0; i < n; i++) x[i] = y[i] / s.a;
+      return true;
+    case NORM:
+      ps.norm(&y[0]);
+      for (int i = 0; i < n; i++) x[i] = s.a + s.b * y[i];
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+struct BatchPath : public Path {
+  RNG& r;
+  Matrix M;
+  BatchPath(RNG& r_) : Path("batch"), r(r_), M(BLOCK) {}
+  bool fill(const Spec& s, double* x, int n)
+  {
+    if (!::fill(r, M, s)) return false;
+    for (int i = 0; i < n; i++) x[i] = M(i);
+    return true;
+  }
+};
+
+struct ParPath : public Path {
+  RNGPar<double>& r;
+  ParPath(RNGPar<double>& r_) : Path("parallel"), r(r_) {}
+  bool fill(const Spec& s, double* x, int n) { return ::fill(r, x, n, s); }
+};
+
+struct RefPath : public Path {
+  gsl_rng* g;
+  RefPath(gsl_rng* g_) : Path("reference"), g(g_) {}
+  bool fill(const Spec& s, double* x, int n)
+  {
+    for (int i = 0; i < n; i++)
+      if (!reference(g, s, x[i])) return false;
+    return true;
+  }
+};
+
+// Stream n draws through stat.  False if the path has no such sampler.
+bool run(Path& path, const Spec& s, long n, gsl_rng* v, EquivStat& stat)
+{
+  vector<double> x(BLOCK);
+  bool exact = cdf(s, 0.0) >= 0;
+
+  for (long done = 0; done < n; done += BLOCK) {
+    int m = (int)std::min((long)BLOCK, n - done);
+    if (!path.fill(s, &x[0], m)) return false;
+    for (int i = 0; i < m; i++) {
+      double u = -1;
+      if (exact) {
+	u = cdf(s, x[i]);
+	if (discrete(s)) {
+	  double u0 = cdf(s, x[i] - 1);
+	  u = u0 + (u - u0) * gsl_rng_uniform(v);
+	}
+      }
+      stat.add(x[i], u);
+    }
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+			      // Main //
+//////////////////////////////////////////////////////////////////////
+
+int nfail = 0;
+
+void report(double p, double alpha, bool& bad)
+{
+  if (p < 0) { printf("%9s", "-"); return; }
+  printf("%9.4f", p);
+  if (p < alpha) bad = true;
+}
+
+int main(int argc, char** argv)
+{
+  long          n     = 1000000;
+  unsigned long seed  = 1234;
+  double        alpha = 1e-4;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:a:")) != -1) {
+    switch (opt) {
+    case 'n': n     = atol(optarg); break;
+    case 's': seed  = strtoul(optarg, NULL, 10); break;
+    case 'a': alpha = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-n draws] [-s seed] [-a alpha]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  RNG            r(seed);
+  RNG            rb(seed + 1);
+  RNGPar<double> rp(3, seed + 2);
+  BufferedRNG    rbuf(seed + 5);
+  TapeRNG        rtape(seed + 8);
+  PhiloxRNG      rphil(seed + 9);
+  SobolRNG       rsob(SobolEngine::MAXDIM, seed + 10);
+  PhiloxStreams  pstr(BLOCK, seed + 11);
+
+  gsl_rng* g = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng* v = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(g, seed + 6);
+  gsl_rng_set(v, seed + 7);
+
+  ScalarPath<RNG>         scalar("scalar", r);
+  BatchPath               batch(rb);
+  ParPath                 par(rp);
+  ScalarPath<BufferedRNG> buffered("buffered", rbuf);
+  ScalarPath<TapeRNG>     tape("tape", rtape);
+  ScalarPath<PhiloxRNG>   philox("philox", rphil);
+  SobolPath               sobol(rsob);
+  StreamsPath             streams(pstr);
+  RefPath                 ref(g);
+
+  Path* paths[] = {&scalar, &batch, &par, &buffered, &tape, &philox, &streams, &sobol};
+  const int NPATH = sizeof(paths) / sizeof(Path*);
+
+  printf("%-22s %-10s %9s %9s %9s %9s %9s %9s %9s\n", "sampler", "path",
+	 "KS", "AD", "chisq", "mean", "var", "KS ref", "chisq ref");
+
+  for (int k = 0; k < NSPEC; k++) {
+    const Spec& s = specs[k];
+    bool exact = cdf(s, 0.0) >= 0;
+    double mu = 0, var = 0;
+    bool mom = moments(s, mu, var);
+
+    EquivStat rs;
+    bool has_ref = run(ref, s, n, v, rs);
+
+    for (int p = -1; p < NPATH; p++) {
+      Path& path = p < 0 ? (Path&)ref : *paths[p];
+      if (p < 0 && !has_ref) continue;
+
+      EquivStat st;
+      if (p >= 0 && !run(path, s, n, v, st)) continue;
+      const EquivStat& t = p < 0 ? rs : st;
+
+      bool bad = false;
+      printf("%-22s %-10s", s.name, path.name);
+      report(exact ? t.ks()    : -1, alpha, bad);
+      report(exact ? t.ad()    : -1, alpha, bad);
+      report(exact ? t.chisq() : -1, alpha, bad);
+      report(mom ? t.mean_test(mu) : -1, alpha, bad);
+      report(mom ? t.var_test(var) : -1, alpha, bad);
+      report(p >= 0 && has_ref && exact ? t.ks(rs)    : -1, alpha, bad);
+      report(p >= 0 && has_ref && exact ? t.chisq(rs) : -1, alpha, bad);
+      printf("%s\n", bad ? "  *" : "");
+      nfail += bad;
+    }
+  }
+
+  // BufferedRNG fills its rings on another thread, but must give what
+  // it gives drawing on demand, draw for draw.  Small rings make the
+  // producer sleep and wake often.
+  {
+    BufferedRNG on(seed + 12, 256u, true), off(seed + 12, 256u, false);
+    long diff = 0;
+    for (long i = 0; i < n; i++) {
+      diff += on.unif() != off.unif();
+      diff += on.norm(1.0) != off.norm(1.0);
+      diff += on.expon_rate(1.0) != off.expon_rate(1.0);
+      diff += on.gamma_rate(2.5, 1.0) != off.gamma_rate(2.5, 1.0);
+    }
+    printf("%-22s %-10s %9li draws differ%s\n", "buffered", "on demand", diff, diff ? "  *" : "");
+    nfail += diff > 0;
+  }
+
+  gsl_rng_free(g);
+  gsl_rng_free(v);
+
+  printf("%i line(s) below alpha = %g.\n", nfail, alpha);
+  return nfail > 0;
+}
@@ -0,0 +1,739 @@
+// -*- c-basic-offset: 4; -*-
+// Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+// This program is free software: you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see
+// <http://www.gnu.org/licenses/>.
+
+// Moment checks of the multivariate and structured samplers, which
+// test_equiv does not reach.
+//
+//   test_moments [-n draws] [-s seed] [-a alpha]
+//
+// Each sampler is drawn n times and the sample moments are compared
+// with their known values by a z-test, using the standard error
+// estimated from the same draws.  A line is marked when its p-value
+// falls below alpha.  The MCMC samplers are thinned first.  Lines that
+// are not z-tests -- ARS refusing a density that is not log concave,
+// RNGExpr matching its array sampler draw for draw, and Philox against
+// its known answers -- are marked when they fail.  Exits 1 if anything
+// was marked.
+
+#include "Matrix.h"
+#include "RNG.hpp"
+#include "RNGExpr.hpp"
+#include "MVNorm.hpp"
+#include "TMVNorm.hpp"
+#include "AliasTable.hpp"
+#include "Wishart.hpp"
+#include "ARS.hpp"
+#include "SliceSampler.hpp"
+#include "PhiloxEngine.hpp"
+#include <unistd.h>
+#include <stdlib.h>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+//////////////////////////////////////////////////////////////////////
+			   // Statistics //
+//////////////////////////////////////////////////////////////////////
+
+double q_z(double z) { return 2.0 * RNGMath::p_norm(-fabs(z)); }
+
+// Draws of a d-vector, kept so that the standard errors of the
+// covariances can be taken about the sample mean.
+class Sample {
+
+ public:
+
+  int d;
+  long n;
+  vector<double> x;
+
+  Sample(int dim) : d(dim), n(0) {}
+
+  void add(const double* y)
+  {
+    x.insert(x.end(), y, y + d);
+    n++;
+  }
+
+  double mean(int i) const
+  {
+    double s = 0;
+    for (long k = 0; k < n; k++) s += x[k*d+i];
+    return s / n;
+  }
+
+  // Sample covariance of components i and j, and its standard error.
+  double cov(int i, int j, double& se) const
+  {
+    double mi = mean(i), mj = mean(j), s = 0, s2 = 0;
+    for (long k = 0; k < n; k++) {
+      double p = (x[k*d+i] - mi) * (x[k*d+j] - mj);
+      s  += p;
+      s2 += p * p;
+    }
+    double c = s / n;
+    se = sqrt((s2 / n - c * c) / n);
+    return c;
+  }
+
+  double mean(int i, double& se) const
+  {
+    double v = cov(i, i, se);
+    se = sqrt(v / n);
+    return mean(i);
+  }
+
+};
+
+//////////////////////////////////////////////////////////////////////
+			    // Report //
+//////////////////////////////////////////////////////////////////////
+
+int    nfail = 0;
+double alpha = 1e-4;
+
+void report(const char* name, const char* what, double est, double target, double se)
+{
+  double z = se > 0 ? (est - target) / se : (est == target ? 0 : HUGE_VAL);
+  double p = q_z(z);
+  bool bad = p < alpha;
+  printf("%-24s %-12s %12.5f %12.5f %9.4f%s\n", name, what, est, target, p, bad ? "  *" : "");
+  nfail += bad;
+}
+
+// A count of entries that should match exactly and did not.
+void check_exact(const char* name, const char* what, int diff)
+{
+  printf("%-24s %-12s %29i entries differ%s\n", name, what, diff, diff ? "  *" : "");
+  nfail += diff > 0;
+}
+
+// Every mean of s against mu.
+void report(const char* name, const Sample& s, const double* mu)
+{
+  char what[32];
+  double se;
+  for (int i = 0; i < s.d; i++) {
+    double m = s.mean(i, se);
+    sprintf(what, "mean[%i]", i);
+    report(name, what, m, mu[i], se);
+  }
+}
+
+// Every mean and covariance of s against mu and the d x d V.
+void report(const char* name, const Sample& s, const double* mu, const double* V)
+{
+  char what[32];
+  double se;
+  report(name, s, mu);
+  for (int i = 0; i < s.d; i++)
+    for (int j = 0; j <= i; j++) {
+      double c = s.cov(i, j, se);
+      sprintf(what, "cov[%i,%i]", i, j);
+      report(name, what, c, V[j*s.d+i], se);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // MVNorm //
+//////////////////////////////////////////////////////////////////////
+
+// P = L L' with L = [1 0 0; 1 1 0; 0 1 1], so V = P^{-1} is integer too.
+const double MV_V[] = { 3, -2,  1,
+		       -2,  2, -1,
+			1, -1,  1};
+const double MV_P[] = { 1,  1,  0,
+			1,  2,  1,
+			0,  1,  2};
+const double MV_M[] = { 1, -2, 0.5};
+const double MV_B[] = { 1,  0, -1};   // V b = (2, -1, 0).
+
+void draw_mvnorm(RNG& r, const MVNorm& mv, bool canonical, long n, Sample& s)
+{
+  const int K = 1000;
+  int d = mv.dim();
+  vector<double> X(d * K);
+  for (long k = 0; k < n; k += K) {
+    if (canonical) mv.draw_canonical(r, &X[0], K, MV_B);
+    else           mv.draw(r, &X[0], K, MV_M);
+    for (int j = 0; j < K; j++) s.add(&X[j*d]);
+  }
+}
+
+void check_mvnorm(RNG& r, long n)
+{
+  MVNorm mv;
+  if (mv.chol() != 0) {
+    printf("MVNorm::chol is not NULL before a set.  *\n");
+    nfail++;
+  }
+
+  double Vb[3] = {2, -1, 0};
+
+  mv.set_cov(MV_V, 3);
+  Sample s1(3);
+  draw_mvnorm(r, mv, false, n, s1);
+  report("mvnorm cov", s1, MV_M, MV_V);
+
+  Sample s2(3);
+  draw_mvnorm(r, mv, true, n, s2);
+  report("mvnorm cov canonical", s2, Vb, MV_V);
+
+  mv.set_prec(MV_P, 3);
+  Sample s3(3);
+  draw_mvnorm(r, mv, false, n, s3);
+  report("mvnorm prec", s3, MV_M, MV_V);
+
+  Sample s4(3);
+  draw_mvnorm(r, mv, true, n, s4);
+  report("mvnorm prec canonical", s4, Vb, MV_V);
+
+  // Not positive definite: the factor fails at the second column.
+  double bad[4] = {1, 2, 2, 1};
+  if (mv.set_cov(bad, 2) || mv.chol() != 0) {
+    printf("MVNorm::chol is not NULL after a failed set.  *\n");
+    nfail++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // TMVNorm //
+//////////////////////////////////////////////////////////////////////
+
+// Sweeps are thinned so that the draws are close enough to independent
+// for the standard errors.
+void draw_tmvnorm(RNG& r, TMVNorm& tmv, long n, Sample& s)
+{
+  const int K = 1000, THIN = 10;
+  int d = tmv.dim();
+  vector<double> X(d * K);
+  tmv.draw(r, &X[0], K, THIN);            // Burn in.
+  for (long k = 0; k < n; k += K) {
+    tmv.draw(r, &X[0], K, THIN);
+    for (int j = 0; j < K; j++) s.add(&X[j*d]);
+  }
+}
+
+void check_tmvnorm(RNG& r, long n)
+{
+  const double PI = 3.14159265358979323846;
+  const double rho = 0.6, sr = sqrt(1 - rho * rho);
+  TMVNorm tmv;
+
+  // Standard bivariate normal on the positive orthant.  With A the
+  // orthant, P(A) = 1/4 + asin(rho) / 2 pi, and by Stein's lemma
+  //   E[X1; A]    = (1 + rho) / 2 sqrt(2 pi),
+  //   E[X1^2; A]  = P(A) + rho sqrt(1 - rho^2) / 2 pi,
+  //   E[X1 X2; A] = rho P(A) + sqrt(1 - rho^2) / 2 pi.
+  {
+    double V[]  = {1, rho, rho, 1};
+    double lo[] = {0, 0};
+    double PA = 0.25 + asin(rho) / (2 * PI);
+    double m  = (1 + rho) / (2 * sqrt(2 * PI) * PA);
+    double v  = 1 + rho * sr / (2 * PI * PA) - m * m;
+    double c  = rho + sr / (2 * PI * PA) - m * m;
+    double mu[] = {m, m};
+    double W[]  = {v, c, c, v};
+
+    tmv.set_cov(V, 2);
+    tmv.set_bounds(lo, NULL);
+    Sample s(2);
+    draw_tmvnorm(r, tmv, n, s);
+    report("tmvnorm orthant", s, mu, W);
+  }
+
+  // X2 < m2 only.  Then X2 - m2 is minus a half normal and X1 is linear
+  // in X2 plus independent noise.
+  {
+    double s1 = 2, s2 = 1;
+    double V[]  = {s1 * s1, rho * s1 * s2, rho * s1 * s2, s2 * s2};
+    double m[]  = {1, -1};
+    double hi[] = {HUGE_VAL, -1};
+    double h  = sqrt(2 / PI);
+    double mu[] = {m[0] - rho * s1 * h, m[1] - s2 * h};
+    double W[]  = {s1 * s1 * (1 - rho * rho * h * h), rho * s1 * s2 * (1 - h * h),
+		   rho * s1 * s2 * (1 - h * h), s2 * s2 * (1 - h * h)};
+
+    tmv.set_cov(V, 2);
+    tmv.set_mean(m);
+    tmv.set_bounds(NULL, hi);
+    Sample s(2);
+    draw_tmvnorm(r, tmv, n, s);
+    report("tmvnorm upper", s, mu, W);
+  }
+
+  // A box and a diagonal precision: independent univariate truncated
+  // normals, with moments from a = (lower - m) / sd, b = (upper - m) / sd.
+  {
+    double P[]  = {1, 0, 0, 4};
+    double m[]  = {0.5, 0};
+    double lo[] = {-1, 0.25};
+    double hi[] = { 2, 1.0};
+    double mu[2], W[] = {0, 0, 0, 0};
+    for (int i = 0; i < 2; i++) {
+      double sd = 1 / sqrt(P[i*3]);
+      double a  = (lo[i] - m[i]) / sd, b = (hi[i] - m[i]) / sd;
+      double Z  = RNGMath::p_norm(b) - RNGMath::p_norm(a);
+      double pa = exp(-0.5 * a * a) / sqrt(2 * PI), pb = exp(-0.5 * b * b) / sqrt(2 * PI);
+      double e  = (pa - pb) / Z;
+      mu[i]     = m[i] + sd * e;
+      W[i*3]    = sd * sd * (1 + (a * pa - b * pb) / Z - e * e);
+    }
+
+    tmv.set_prec(P, 2);
+    tmv.set_mean(m);
+    tmv.set_bounds(lo, hi);
+    Sample s(2);
+    draw_tmvnorm(r, tmv, n, s);
+    report("tmvnorm box", s, mu, W);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+		  // Categorical, Dirichlet, multinomial //
+//////////////////////////////////////////////////////////////////////
+
+// Frequency of each category against w / sum(w).  A zero weight must
+// never be drawn.
+template<typename Draw>
+void check_freq(const char* name, Draw& draw, const double* w, int K, long n)
+{
+  vector<double> count(K, 0.0);
+  double total = 0;
+  for (int k = 0; k < K; k++) total += w[k];
+  for (long i = 0; i < n; i++) count[draw()] += 1;
+
+  char what[32];
+  for (int k = 0; k < K; k++) {
+    double p = w[k] / total;
+    sprintf(what, "freq[%i]", k);
+    report(name, what, count[k] / n, p, sqrt(p * (1 - p) / n));
+  }
+}
+
+struct TableDraw {
+  RNG& r; const AliasTable& tab;
+  TableDraw(RNG& r_, const AliasTable& tab_) : r(r_), tab(tab_) {}
+  int operator()() { return tab.draw(r.unif()); }
+};
+
+struct CategDraw {
+  RNG& r; const double* w; int K; bool use_log;
+  CategDraw(RNG& r_, const double* w_, int K_, bool l) : r(r_), w(w_), K(K_), use_log(l) {}
+  int operator()() { return use_log ? r.categorical_log(w, K) : r.categorical(w, K); }
+};
+
+void check_categorical(RNG& r, long n)
+{
+  const int K = 5;
+  double w[K]  = {2.0, 0.0, 0.5, 1.0, 0.5};
+  double lw[K];
+  // Log weights far below exp's range, as from log likelihoods.
+  for (int k = 0; k < K; k++) lw[k] = w[k] > 0 ? log(w[k]) - 800.0 : -HUGE_VAL;
+
+  AliasTable tab(w, K);
+  TableDraw td(r, tab);
+  check_freq("alias", td, w, K, n);
+
+  AliasTable ltab(lw, K, true);
+  TableDraw ld(r, ltab);
+  check_freq("alias log", ld, w, K, n);
+
+  CategDraw cd(r, w, K, false);
+  check_freq("categorical", cd, w, K, n);
+
+  CategDraw cl(r, lw, K, true);
+  check_freq("categorical_log", cl, w, K, n);
+}
+
+// X ~ Dir(a), a0 = sum(a): E X = a / a0 and
+// Cov X = (a0 diag(a) - a a') / (a0^2 (a0 + 1)).  a[0] and a[1] take
+// the log path for shape < 1.
+void check_dirichlet(RNG& r, long n)
+{
+  const int K = 3;
+  double a[K] = {0.1, 0.5, 2.0};
+  double a0 = a[0] + a[1] + a[2];
+  double mu[K], V[K*K];
+  for (int i = 0; i < K; i++) {
+    mu[i] = a[i] / a0;
+    for (int j = 0; j < K; j++)
+      V[j*K+i] = ((i == j) * a0 * a[i] - a[i] * a[j]) / (a0 * a0 * (a0 + 1));
+  }
+
+  Sample s(K);
+  double x[K];
+  for (long k = 0; k < n; k++) {
+    r.dirichlet(x, a, K);
+    s.add(x);
+  }
+  report("dirichlet", s, mu, V);
+}
+
+// X ~ Mult(N, p): E X = N p and Cov X = N (diag(p) - p p').
+void check_multinomial(RNG& r, long n)
+{
+  const int K = 4, N = 20;
+  double p[K] = {0.1, 0.0, 0.6, 0.3};
+  double mu[K], V[K*K];
+  for (int i = 0; i < K; i++) {
+    mu[i] = N * p[i];
+    for (int j = 0; j < K; j++)
+      V[j*K+i] = N * ((i == j) * p[i] - p[i] * p[j]);
+  }
+
+  Sample s(K);
+  int c[K];
+  double x[K];
+  for (long k = 0; k < n; k++) {
+    r.multinomial(c, N, p, K);
+    for (int i = 0; i < K; i++) x[i] = c[i];
+    s.add(x);
+  }
+  report("multinomial", s, mu, V);
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // Wishart //
+//////////////////////////////////////////////////////////////////////
+
+// The draws, or C C' from the factors alone, as d*d vectors.
+void draw_wishart(RNG& r, const Wishart& w, double nu, bool conly, long n, Sample& s)
+{
+  const int K = 100;
+  int d = w.dim(), dd = d * d;
+  vector<double> X(dd * K), C(dd * K), W(dd);
+  for (long k = 0; k < n; k += K) {
+    w.draw(r, nu, conly ? NULL : &X[0], K, conly ? &C[0] : NULL);
+    for (int j = 0; j < K; j++) {
+      if (!conly) { s.add(&X[j*dd]); continue; }
+      const double* Cj = &C[j*dd];
+      for (int a = 0; a < d; a++)
+	for (int b = 0; b < d; b++) {
+	  double t = 0;
+	  for (int c = 0; c < d; c++) t += Cj[c*d+a] * Cj[c*d+b];
+	  W[b*d+a] = t;
+	}
+      s.add(&W[0]);
+    }
+  }
+}
+
+// E W = nu S for W ~ W(nu, S) and E X = Psi / (nu - d - 1) for
+// X ~ IW(nu, Psi).  The factor alone gives C C' ~ W(nu, S), or
+// W(nu, Psi^{-1}) for the inverse.  MV_P is MV_V^{-1}.  nu is large
+// enough that IW has the fourth moments the standard errors need.
+void check_wishart(RNG& r, long n)
+{
+  const int d = 3;
+  const double nu = 12;
+  double mu[d*d];
+  Wishart w;
+  if (w.chol() != 0) {
+    printf("Wishart::chol is not NULL before a set.  *\n");
+    nfail++;
+  }
+
+  w.set_scale(MV_V, d);
+  for (int i = 0; i < d*d; i++) mu[i] = nu * MV_V[i];
+  Sample s1(d*d);
+  draw_wishart(r, w, nu, false, n, s1);
+  report("wishart", s1, mu);
+
+  Sample s2(d*d);
+  draw_wishart(r, w, nu, true, n, s2);
+  report("wishart C", s2, mu);
+
+  w.set_inv_scale(MV_V, d);
+  for (int i = 0; i < d*d; i++) mu[i] = MV_V[i] / (nu - d - 1);
+  Sample s3(d*d);
+  draw_wishart(r, w, nu, false, n, s3);
+  report("inv wishart", s3, mu);
+
+  for (int i = 0; i < d*d; i++) mu[i] = nu * MV_P[i];
+  Sample s4(d*d);
+  draw_wishart(r, w, nu, true, n, s4);
+  report("inv wishart C", s4, mu);
+
+  double bad[4] = {1, 2, 2, 1};
+  if (w.set_scale(bad, 2) || w.chol() != 0) {
+    printf("Wishart::chol is not NULL after a failed set_scale.  *\n");
+    nfail++;
+  }
+  w.set_scale(MV_V, d);
+  if (w.set_inv_scale(bad, 2) || w.chol() != 0) {
+    printf("Wishart::chol is not NULL after a failed set_inv_scale.  *\n");
+    nfail++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+			  // ARS and slice //
+//////////////////////////////////////////////////////////////////////
+
+// Log densities, with h' for ARS and -inf off the support for the
+// slice sampler.
+
+struct NormDens {
+  double operator()(double x, double& dh) const { dh = -x; return -0.5 * x * x; }
+  double operator()(double x) const { return -0.5 * x * x; }
+};
+
+struct GammaDens {
+  double a;
+  GammaDens(double a_) : a(a_) {}
+  double operator()(double x, double& dh) const
+  { dh = (a - 1) / x - 1; return (a - 1) * log(x) - x; }
+  double operator()(double x) const
+  { return x > 0 ? (a - 1) * log(x) - x : -HUGE_VAL; }
+};
+
+struct BetaDens {
+  double a, b;
+  BetaDens(double a_, double b_) : a(a_), b(b_) {}
+  double operator()(double x, double& dh) const
+  { dh = (a - 1) / x - (b - 1) / (1 - x); return (a - 1) * log(x) + (b - 1) * log(1 - x); }
+  double operator()(double x) const
+  { return x > 0 && x < 1 ? (a - 1) * log(x) + (b - 1) * log(1 - x) : -HUGE_VAL; }
+};
+
+// Log concave only on [-1, 1].
+struct CauchyDens {
+  double operator()(double x, double& dh) const
+  { dh = -2 * x / (1 + x * x); return -log(1 + x * x); }
+};
+
+// Two modes, at about -2 and 2.
+struct MixDens {
+  double operator()(double x) const
+  { return log(exp(-0.5 * (x + 2) * (x + 2)) + exp(-0.5 * (x - 2) * (x - 2))); }
+};
+
+template<typename Sampler>
+void draw_ars(RNG& r, Sampler& ars, long n, Sample& s)
+{
+  vector<double> X(n);
+  ars.draw(r, &X[0], n);
+  for (long k = 0; k < n; k++) s.add(&X[k]);
+}
+
+// Transitions are thinned so that the states are close enough to
+// independent for the standard errors.
+template<typename Sampler>
+void draw_slice(RNG& r, Sampler& ss, long n, Sample& s, int thin=10)
+{
+  vector<double> X(n);
+  ss.draw(r, &X[0], 100, thin);         // Burn in.
+  ss.draw(r, &X[0], n, thin);
+  for (long k = 0; k < n; k++) s.add(&X[k]);
+}
+
+void check_ars(RNG& r, long n)
+{
+  // N(0, 1), Ga(2.5, 1), and Be(2, 3), which has bounded support.
+  double m_norm[] = {0}, v_norm[] = {1};
+  double m_gam[]  = {2.5}, v_gam[] = {2.5};
+  double m_beta[] = {0.4}, v_beta[] = {0.04};
+
+  double in_norm[] = {-1, 1};
+  ARS<NormDens> an(NormDens(), in_norm, 2);
+  Sample s1(1);
+  draw_ars(r, an, n, s1);
+  report("ars norm", s1, m_norm, v_norm);
+
+  double in_gam[] = {1, 4};
+  ARS<GammaDens> ag(GammaDens(2.5), in_gam, 2, 0.0);
+  Sample s2(1);
+  draw_ars(r, ag, n, s2);
+  report("ars gamma", s2, m_gam, v_gam);
+
+  double in_beta[] = {0.2, 0.7};
+  ARS<BetaDens> ab(BetaDens(2, 3), in_beta, 2, 0.0, 1.0);
+  Sample s3(1);
+  draw_ars(r, ab, n, s3);
+  report("ars beta", s3, m_beta, v_beta);
+
+  // h' rises from -3 to -2, so set must refuse the Cauchy.
+  double in_cau[] = {-3, -2, 2, 3};
+  ARS<CauchyDens> ac((CauchyDens()));
+  bool bad = ac.set(in_cau, 4) || ac.is_set();
+  printf("%-24s %-12s %38s%s\n", "ars cauchy", "set", bad ? "accepted" : "rejected", bad ? "  *" : "");
+  nfail += bad;
+
+  SliceSampler<NormDens> sn(NormDens(), 0.0, 2.0);
+  Sample s4(1);
+  draw_slice(r, sn, n, s4);
+  report("slice norm", s4, m_norm, v_norm);
+
+  SliceSampler<GammaDens> sg(GammaDens(2.5), 1.0, 2.0, 100, 0.0);
+  Sample s5(1);
+  draw_slice(r, sg, n, s5);
+  report("slice gamma", s5, m_gam, v_gam);
+
+  SliceSampler<BetaDens> sb(BetaDens(2, 3), 0.5, 0.5, 100, 0.0, 1.0);
+  Sample s6(1);
+  draw_slice(r, sb, n, s6);
+  report("slice beta", s6, m_beta, v_beta);
+
+  // Not log concave: an equal mixture of N(-2, 1) and N(2, 1).  The
+  // chain crosses between the modes slowly, so thin more.
+  double m_mix[] = {0}, v_mix[] = {5};
+  SliceSampler<MixDens> sm(MixDens(), 0.0, 4.0);
+  Sample s7(1);
+  draw_slice(r, sm, n, s7, 50);
+  report("slice mixture", s7, m_mix, v_mix);
+}
+
+//////////////////////////////////////////////////////////////////////
+			   // RNGExpr //
+//////////////////////////////////////////////////////////////////////
+
+// An expression with one source is exactly its array sampler followed
+// by the arithmetic, under the same seed.  The length is not a
+// multiple of RNG_BLOCK so that the last block is partial.
+void check_expr(unsigned long seed)
+{
+  int m = 3 * RNG_BLOCK + 17;
+  Matrix A(m, 1), B(m, 1);
+  RNG ra(seed), rb(seed);
+
+  fill(A, 2.0 * norm_expr(ra) + 1.0);
+  rb.norm(B, 0.0, 1.0);
+  int diff = 0;
+  for (int i = 0; i < m; i++) diff += A(i) != 2.0 * B(i) + 1.0;
+  check_exact("expr norm", "exact", diff);
+
+  fill(A, square(gamma_expr(ra, 2.5, 1.0)) - 3.0);
+  rb.gamma_rate(B, 2.5, 1.0);
+  diff = 0;
+  for (int i = 0; i < m; i++) diff += A(i) != B(i) * B(i) - 3.0;
+  check_exact("expr gamma", "exact", diff);
+}
+
+//////////////////////////////////////////////////////////////////////
+			    // Philox //
+//////////////////////////////////////////////////////////////////////
+
+// The Random123 known-answer vectors for Philox4x32-10, then PhiloxRNG
+// and PhiloxStreams against PhiloxRNG.  Stream i of
+// PhiloxStreams(n, seed, first) must read the blocks of
+// PhiloxRNG(seed, first + i), and chain and resume must hand a stream
+// back and forth without losing or repeating a block.
+void check_philox()
+{
+  const uint32_t kat[3][10] = {
+    {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+     0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+    {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+     0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+    {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+     0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+  int diff = 0;
+  for (int k = 0; k < 3; k++) {
+    uint32_t out[4];
+    philox4x32(kat[k], kat[k] + 4, out);
+    for (int j = 0; j < 4; j++) diff += out[j] != kat[k][6+j];
+  }
+  check_exact("philox4x32", "known", diff);
+
+  // Counter (0, 0, 0, 0), key 0: block 0 of stream 0 under seed 0.
+  PhiloxRNG r0(0, 0);
+  diff = 0;
+  for (int j = 0; j < 4; j++) diff += r0.bits32() != kat[0][6+j];
+  check_exact("PhiloxRNG", "known", diff);
+
+  const size_t n = 37;                  // Not a multiple of LANES.
+  const unsigned long seed = (unsigned long)((uint64_t)0x1234 << 32 | 0x56789abcu);
+  const uint64_t first = 5;
+  const int nblock = 6;
+  PhiloxStreams ps(n, seed, first);
+  vector<double> U(n), Z(n), E(n);
+
+  // Blocks 0 and 1 by unif, 2 and 3 by norm, 4 and 5 by expon.
+  diff = 0;
+  for (int b = 0; b < nblock; b++) {
+    if      (b < 2) ps.unif(&U[0]);
+    else if (b < 4) ps.norm(&Z[0]);
+    else            ps.expon(&E[0]);
+    for (size_t i = 0; i < n; i++) {
+      PhiloxRNG r(seed, first + i);
+      r.seek(b);
+      double u1 = r.unif(), u2 = r.unif();
+      if      (b < 2) diff += U[i] != u1;
+      else if (b < 4) diff += Z[i] != sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+      else            diff += E[i] != -log(u1);
+    }
+  }
+  check_exact("PhiloxStreams", "streams", diff);
+
+  // Stream 3 is taken out, draws three uniforms, two blocks, and comes
+  // back; the others have not moved.
+  diff = 0;
+  PhiloxRNG c = ps.chain(3);
+  diff += c.block() != (uint64_t)nblock || c.stream() != first + 3;
+  c.unif(); c.unif(); c.unif();
+  ps.resume(3, c);
+  ps.unif(&U[0]);
+  for (size_t i = 0; i < n; i++) {
+    PhiloxRNG r(seed, first + i);
+    r.seek(nblock + (i == 3 ? 2 : 0));
+    diff += U[i] != r.unif();
+  }
+  check_exact("PhiloxStreams", "chain", diff);
+}
+
+//////////////////////////////////////////////////////////////////////
+			     // Main //
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  long          n    = 200000;
+  unsigned long seed = 1234;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:a:")) != -1) {
+    switch (opt) {
+    case 'n': n     = atol(optarg); break;
+    case 's': seed  = strtoul(optarg, NULL, 10); break;
+    case 'a': alpha = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-n draws] [-s seed] [-a alpha]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  RNG r(seed);
+
+  printf("%-24s %-12s %12s %12s %9s\n", "sampler", "moment", "sample", "target", "p");
+
+  check_mvnorm(r, n);
+  check_tmvnorm(r, n);
+  check_categorical(r, n);
+  check_dirichlet(r, n);
+  check_multinomial(r, n);
+  check_wishart(r, n);
+  check_ars(r, n);
+  check_expr(seed);
+  check_philox();
+
+  printf("%i line(s) below alpha = %g.\n", nfail, alpha);
+  return nfail > 0;
+}
@@ -2,6 +2,7 @@
 #include "RNG.hpp"
 #include "RNGParallel.hpp"
 #include "CPURNG.hpp"
+#include "MapSink.hpp"
 #include <vector>
 #include <time.h>
 #include <sys/time.h>
@@ -63,8 +64,44 @@ void testRNGPar() {
 
 }
 
+void testMapSink() {
+
+  unsigned long nsamp = 5000000;
+  int nthread = 3;
+
+  RNGPar<double> r(nthread, 1234);
+
+  double mean = 1.0;
+  double sd   = 2.0;
+
+  MapSink out;
+  if (!out.open<double>("norm.bin", nsamp, r.engine(), r.get_seed(), r.size())) return;
+
+  size_t n;
+  while (double* b = out.next<double>(n))
+    r.norm(b, n, &mean, &sd, 1);
+
+  out.close();
+
+  MapSource in("norm.bin");
+  const double* x = in.data<double>();
+  if (!x) return;
+
+  double s1 = 0, s2 = 0;
+  for (unsigned long i = 0; i < in.size(); i++) {
+    s1 += x[i];
+    s2 += x[i] * x[i];
+  }
+  s1 /= in.size();
+  s2  = s2 / in.size() - s1 * s1;
+
+  printf("MapSink: %lu draws, mean %g, var %g.\n", (unsigned long)in.size(), s1, s2);
+
+}
+
 int main() {
 
   testRNGPar();
+  testMapSink();
 
 }
@@ -0,0 +1,126 @@
+# Copyright 2013 Jesse Windle - jesse.windle@gmail.com
+
+# This program is free software: you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version 3 of
+# the License, or (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see
+# <http://www.gnu.org/licenses/>.
+
+# A quick check of the Python bindings, pyrng, without NumPy: buffers
+# are array.array('d').  It checks that parameters are recycled, that
+# a seed repeats its draws, that bad arguments raise, and that tnorm
+# stays within its bounds.  Each failure prints a line marked *.
+# Exits 1 if anything failed.
+#
+#   make pyrng && python3 test_pyrng.py
+
+import sys
+from array import array
+from math import isinf, sqrt
+
+import pyrng
+
+nfail = 0
+
+def check(what, ok):
+    global nfail
+    print("%-48s %s" % (what, "ok" if ok else "failed  *"))
+    if not ok:
+        nfail += 1
+
+def raises(what, exc, f, *args):
+    try:
+        f(*args)
+    except exc:
+        check(what, True)
+    except Exception as e:
+        check(what + " (raised %s)" % type(e).__name__, False)
+    else:
+        check(what + " (did not raise)", False)
+
+def mean(x):
+    return sum(x) / len(x)
+
+def zeros(n):
+    return array('d', bytes(8 * n))
+
+##############################################################################
+                                # Recycling #
+##############################################################################
+
+# out[i] uses mean mu[i % 3], so each third of the draws has its own
+# mean; the sd is 1, so 5 standard errors is 5 / sqrt(n / 3).
+n   = 30000
+mu  = array('d', [0.0, 10.0, -10.0])
+tol = 5 / sqrt(n / 3)
+
+for name, r in (("RNGPar", pyrng.RNGPar(3, 1234)), ("RNG", pyrng.RNG(1234))):
+    x = zeros(n)
+    r.norm(x, mu, 1.0)
+    ok = all(abs(mean(x[k::3]) - mu[k]) < tol for k in range(3))
+    check("%s norm recycles the mean" % name, ok)
+
+    x = zeros(n)
+    r.gamma_rate(x, 2.0, array('d', [1.0, 2.0]))
+    ok = abs(mean(x[0::2]) - 2.0) < 10 * tol and abs(mean(x[1::2]) - 1.0) < 10 * tol
+    check("%s gamma_rate recycles the rate" % name, ok)
+
+##############################################################################
+                                  # Seeds #
+##############################################################################
+
+a, b = zeros(1000), zeros(1000)
+pyrng.RNGPar(2, 7).norm(a, 0.0, 1.0)
+pyrng.RNGPar(2, 7).norm(b, 0.0, 1.0)
+check("RNGPar repeats a seed", a == b)
+check("RNGPar get_seed and size", pyrng.RNGPar(2, 7).get_seed() == 7
+      and pyrng.RNGPar(2, 7).size() == 2)
+
+a, b = zeros(1000), zeros(1000)
+pyrng.RNG(7).unif(a)
+pyrng.RNG(7).unif(b)
+check("RNG repeats a seed", a == b)
+check("RNG unif is in (0, 1)", all(0 < v < 1 for v in a))
+
+##############################################################################
+                               # Bad arguments #
+##############################################################################
+
+for name, r in (("RNGPar", pyrng.RNGPar(2, 1)), ("RNG", pyrng.RNG(1))):
+    x = zeros(10)
+    raises("%s rejects a list for out" % name, TypeError, r.norm, [0.0] * 10, 0.0, 1.0)
+    raises("%s rejects floats for out" % name, TypeError, r.norm, array('f', [0] * 10), 0.0, 1.0)
+    raises("%s rejects read only out" % name, BufferError, r.norm, bytes(80), 0.0, 1.0)
+    raises("%s rejects ints for a parameter" % name, TypeError, r.norm, x, array('i', [0, 1]), 1.0)
+    raises("%s rejects a string parameter" % name, TypeError, r.norm, x, "0", 1.0)
+    raises("%s rejects a length that does not divide" % name, ValueError,
+           r.norm, x, array('d', [0.0, 1.0, 2.0]), 1.0)
+    raises("%s rejects too few arguments" % name, TypeError, r.norm, x, 0.0)
+
+raises("RNGPar rejects nthread 0", ValueError, pyrng.RNGPar, 0, 1)
+raises("RNG rejects a negative seed", OverflowError, pyrng.RNG, -1)
+raises("RNG tnorm rejects buffer parameters", TypeError,
+       pyrng.RNG(1).tnorm, zeros(10), array('d', [0.0]), 1.0, 0.0, 1.0)
+
+##############################################################################
+                                  # tnorm #
+##############################################################################
+
+r = pyrng.RNG(99)
+for left, right, m, s in ((1.0, 2.0, 0.0, 1.0), (-0.5, 0.5, 3.0, 2.0),
+                          (4.0, float("inf"), 0.0, 1.0), (-1.0, float("inf"), 0.0, 1.0)):
+    x = zeros(5000)
+    r.tnorm(x, left, right, m, s)
+    ok = all(left <= v and (isinf(right) or v <= right) for v in x)
+    check("RNG tnorm in [%g, %g]" % (left, right), ok)
+
+print("%i check(s) failed." % nfail)
+sys.exit(nfail > 0)